@@ -0,0 +1,256 @@
+// AnsiParser.cpp
+#include "AnsiParser.h"
+
+#include <algorithm> // std::min
+
+/*
+ * Each table entry packs the action to perform in the high nibble and the next state
+ * in the low nibble. The value Stay keeps the current state without running any entry
+ * or exit action.
+ */
+static constexpr uint8_t Stay = 0x0F;
+
+struct AnsiParser::TransitionTable {
+    uint8_t entries[StateCount][256];
+
+    constexpr void set(State state, int from, int to, Action action, uint8_t next = Stay) {
+        for (int byte = from; byte <= to; ++byte) {
+            entries[state][byte] = static_cast<uint8_t>((action << 4) | next);
+        }
+    }
+
+    // C0 controls other than CAN, SUB and ESC, which are handled for every state below
+    constexpr void setControls(State state, Action action) {
+        set(state, 0x00, 0x17, action);
+        set(state, 0x19, 0x19, action);
+        set(state, 0x1C, 0x1F, action);
+    }
+
+    constexpr TransitionTable() : entries{} {
+        for (int state = 0; state < StateCount; ++state) {
+            set(State(state), 0x00, 0xFF, Ignore);
+        }
+
+        set(Ground, 0x20, 0x7E, Print);
+        set(Ground, 0x80, 0xFF, Print); // UTF-8 lead and continuation bytes
+        setControls(Ground, Execute);
+
+        setControls(Escape, Execute);
+        set(Escape, 0x20, 0x2F, Collect, EscapeIntermediate);
+        set(Escape, 0x30, 0x7E, EscDispatch, Ground);
+        set(Escape, 0x5B, 0x5B, NoAction, CsiEntry); // ESC [
+        set(Escape, 0x5D, 0x5D, NoAction, OscString); // ESC ]
+        set(Escape, 0x50, 0x50, NoAction, DcsEntry); // ESC P
+        set(Escape, 0x58, 0x58, NoAction, SosPmApcString); // ESC X
+        set(Escape, 0x5E, 0x5F, NoAction, SosPmApcString); // ESC ^, ESC _
+
+        setControls(EscapeIntermediate, Execute);
+        set(EscapeIntermediate, 0x20, 0x2F, Collect);
+        set(EscapeIntermediate, 0x30, 0x7E, EscDispatch, Ground);
+
+        setControls(CsiEntry, Execute);
+        set(CsiEntry, 0x20, 0x2F, Collect, CsiIntermediate);
+        set(CsiEntry, 0x30, 0x3B, Param, CsiParam); // Digits, ':' and ';'
+        set(CsiEntry, 0x3C, 0x3F, Collect, CsiParam); // Private marker
+        set(CsiEntry, 0x40, 0x7E, CsiDispatch, Ground);
+
+        setControls(CsiParam, Execute);
+        set(CsiParam, 0x30, 0x3B, Param); // Sub-parameters (38:2:r:g:b) are flattened
+        set(CsiParam, 0x3C, 0x3F, NoAction, CsiIgnore);
+        set(CsiParam, 0x20, 0x2F, Collect, CsiIntermediate);
+        set(CsiParam, 0x40, 0x7E, CsiDispatch, Ground);
+
+        setControls(CsiIntermediate, Execute);
+        set(CsiIntermediate, 0x20, 0x2F, Collect);
+        set(CsiIntermediate, 0x30, 0x3F, NoAction, CsiIgnore);
+        set(CsiIntermediate, 0x40, 0x7E, CsiDispatch, Ground);
+
+        setControls(CsiIgnore, Execute);
+        set(CsiIgnore, 0x40, 0x7E, NoAction, Ground);
+
+        set(DcsEntry, 0x20, 0x2F, Collect, DcsIntermediate);
+        set(DcsEntry, 0x30, 0x3B, Param, DcsParam);
+        set(DcsEntry, 0x3C, 0x3F, Collect, DcsParam);
+        set(DcsEntry, 0x40, 0x7E, NoAction, DcsPassthrough);
+
+        set(DcsParam, 0x30, 0x3B, Param);
+        set(DcsParam, 0x3C, 0x3F, NoAction, DcsIgnore);
+        set(DcsParam, 0x20, 0x2F, Collect, DcsIntermediate);
+        set(DcsParam, 0x40, 0x7E, NoAction, DcsPassthrough);
+
+        set(DcsIntermediate, 0x20, 0x2F, Collect);
+        set(DcsIntermediate, 0x30, 0x3F, NoAction, DcsIgnore);
+        set(DcsIntermediate, 0x40, 0x7E, NoAction, DcsPassthrough);
+
+        setControls(DcsPassthrough, Put);
+        set(DcsPassthrough, 0x20, 0x7E, Put);
+        set(DcsPassthrough, 0x80, 0xFF, Put);
+
+        set(OscString, 0x20, 0xFF, OscPut);
+        set(OscString, 0x7F, 0x7F, Ignore);
+        set(OscString, 0x07, 0x07, NoAction, Ground); // BEL terminates OSC (xterm extension)
+
+        // Transitions that apply from any state
+        for (int state = 0; state < StateCount; ++state) {
+            set(State(state), 0x18, 0x18, Execute, Ground); // CAN
+            set(State(state), 0x1A, 0x1A, Execute, Ground); // SUB
+            set(State(state), 0x1B, 0x1B, NoAction, Escape); // ESC, also the start of ST
+        }
+    }
+};
+
+const AnsiParser::TransitionTable AnsiParser::transitions;
+
+AnsiParser::AnsiParser(AnsiHandler *handler) : handler(handler), currentState(Ground), params{}, paramCount(0), privateMarker(0), intermediates{}, intermediateCount(0), dcsFinalByte(0) {}
+
+void AnsiParser::reset() {
+    currentState = Ground;
+    paramCount = 0;
+    privateMarker = 0;
+    intermediateCount = 0;
+    stringBuffer.clear();
+}
+
+void AnsiParser::feed(const char *data, size_t len) {
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+    const unsigned char *end = p + len;
+
+    while (p < end) {
+        // Fast paths: plain text and string payloads are consumed as whole runs
+        if (currentState == Ground) {
+            const unsigned char *run = p;
+            while (p < end && *p >= 0x20 && *p != 0x7F) {
+                ++p;
+            }
+            if (p != run) {
+                handler->print(reinterpret_cast<const char *>(run), p - run);
+            }
+            if (p == end) {
+                break;
+            }
+        } else if (currentState == OscString || currentState == DcsPassthrough) {
+            const unsigned char *run = p;
+            while (p < end && *p >= 0x20 && *p != 0x7F) {
+                ++p;
+            }
+            size_t room = MaxStringLength - std::min(MaxStringLength, stringBuffer.size());
+            stringBuffer.append(reinterpret_cast<const char *>(run), std::min(room, size_t(p - run)));
+            if (p == end) {
+                break;
+            }
+        }
+
+        unsigned char byte = *p++;
+        uint8_t entry = transitions.entries[currentState][byte];
+        Action action = Action(entry >> 4);
+        uint8_t next = entry & 0x0F;
+
+        if (next == Stay) {
+            perform(action, byte);
+        } else {
+            leave(byte);
+            perform(action, byte);
+            enter(State(next), byte);
+        }
+    }
+}
+
+void AnsiParser::leave(unsigned char byte) {
+    if (currentState == OscString) {
+        perform(OscEnd, byte);
+    } else if (currentState == DcsPassthrough) {
+        perform(Unhook, byte);
+    }
+}
+
+void AnsiParser::enter(State next, unsigned char byte) {
+    currentState = next;
+    switch (next) {
+    case Escape:
+    case CsiEntry:
+    case DcsEntry:
+        perform(Clear, byte);
+        break;
+    case OscString:
+        perform(OscStart, byte);
+        break;
+    case DcsPassthrough:
+        perform(Hook, byte);
+        break;
+    default:
+        break;
+    }
+}
+
+void AnsiParser::perform(Action action, unsigned char byte) {
+    switch (action) {
+    case Print: {
+        char c = char(byte);
+        handler->print(&c, 1);
+        break;
+    }
+    case Execute:
+        handler->execute(byte);
+        break;
+    case Clear:
+        paramCount = 0;
+        privateMarker = 0;
+        intermediateCount = 0;
+        break;
+    case Collect:
+        if (byte >= 0x3C && byte <= 0x3F) {
+            privateMarker = char(byte);
+        } else if (intermediateCount < MaxIntermediates) {
+            intermediates[intermediateCount++] = char(byte);
+        }
+        break;
+    case Param:
+        if (paramCount == 0) {
+            params[0] = 0;
+            paramCount = 1;
+        }
+        if (byte == ';' || byte == ':') {
+            if (paramCount < MaxParams) {
+                params[paramCount] = 0;
+            }
+            ++paramCount; // Past MaxParams further digits are ignored
+            if (paramCount > MaxParams + 1) {
+                paramCount = MaxParams + 1;
+            }
+        } else if (paramCount <= MaxParams) {
+            int &value = params[paramCount - 1];
+            value = std::min(value * 10 + (byte - '0'), 0xFFFF);
+        }
+        break;
+    case EscDispatch:
+        handler->escDispatch(intermediates, intermediateCount, char(byte));
+        break;
+    case CsiDispatch:
+        handler->csiDispatch(params, std::min(paramCount, MaxParams), privateMarker, intermediates, intermediateCount, char(byte));
+        break;
+    case Hook:
+        dcsFinalByte = char(byte);
+        stringBuffer.clear();
+        break;
+    case Put:
+    case OscPut:
+        if (stringBuffer.size() < MaxStringLength) {
+            stringBuffer.push_back(char(byte));
+        }
+        break;
+    case Unhook:
+        handler->dcsDispatch(params, std::min(paramCount, MaxParams), intermediates, intermediateCount, dcsFinalByte, stringBuffer.data(), stringBuffer.size());
+        stringBuffer.clear();
+        break;
+    case OscStart:
+        stringBuffer.clear();
+        break;
+    case OscEnd:
+        handler->oscDispatch(stringBuffer.data(), stringBuffer.size());
+        stringBuffer.clear();
+        break;
+    case NoAction:
+    case Ignore:
+        break;
+    }
+}
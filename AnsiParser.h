@@ -0,0 +1,112 @@
+// AnsiParser.h
+
+#ifndef ANSIPARSER_H
+#define ANSIPARSER_H
+
+#include <cstddef> // size_t
+#include <cstdint> // Fixed width integer types for the transition table
+#include <string> // Buffer for OSC / DCS payloads
+
+/**
+ * @file AnsiParser.h
+ * @brief Streaming, table-driven VT/ANSI escape sequence parser.
+ *
+ * The parser implements the DEC VT500 state machine (CSI, OSC, DCS, ESC sequences
+ * such as charset selection) as a single pass over the byte stream. All state lives
+ * in the parser object, so a sequence split across two PTY reads is completed on the
+ * next call to feed() instead of leaking through as garbage.
+ *
+ * Bytes >= 0x80 are treated as printable so UTF-8 text passes through untouched; 8-bit
+ * C1 controls are not recognised, matching xterm in UTF-8 mode.
+ */
+
+/**
+ * @brief Receives the decoded actions of an AnsiParser.
+ *
+ * print() is called with whole runs of printable bytes, never byte by byte, so plain
+ * text costs one virtual call per run.
+ */
+class AnsiHandler {
+public:
+    virtual ~AnsiHandler() = default;
+
+    virtual void print(const char *data, size_t len) = 0; // Run of printable bytes (UTF-8 passed through)
+    virtual void execute(unsigned char control) = 0; // C0 control such as \n, \r, \b, BEL
+    // CSI sequence; privateMarker is one of '?', '>', '<', '=' or 0
+    virtual void csiDispatch(const int *params, int paramCount, char privateMarker,
+                             const char *intermediates, int intermediateCount, char final) = 0;
+    // ESC sequence, e.g. ESC ( B arrives as intermediates "(" and final 'B'
+    virtual void escDispatch(const char *intermediates, int intermediateCount, char final) = 0;
+    virtual void oscDispatch(const char *data, size_t len) = 0; // OSC payload without ESC ] and terminator
+    // DCS sequence with its (bounded) payload; ignored unless overridden
+    virtual void dcsDispatch(const int *, int, const char *, int, char, const char *, size_t) {}
+};
+
+class AnsiParser {
+public:
+    static constexpr int MaxParams = 16; // Extra parameters are dropped, like xterm
+    static constexpr int MaxIntermediates = 2;
+    static constexpr size_t MaxStringLength = 4096; // Cap for OSC/DCS payloads
+
+    enum State : uint8_t {
+        Ground,
+        Escape,
+        EscapeIntermediate,
+        CsiEntry,
+        CsiParam,
+        CsiIntermediate,
+        CsiIgnore,
+        DcsEntry,
+        DcsParam,
+        DcsIntermediate,
+        DcsPassthrough,
+        DcsIgnore,
+        OscString,
+        SosPmApcString,
+        StateCount
+    };
+
+    explicit AnsiParser(AnsiHandler *handler); // The handler must outlive the parser
+
+    void feed(const char *data, size_t len); // Parse a chunk, carrying state over to the next call
+    void reset(); // Return to the ground state and drop any partial sequence
+    State state() const { return currentState; }
+
+private:
+    enum Action : uint8_t {
+        NoAction,
+        Print,
+        Execute,
+        Clear,
+        Collect,
+        Param,
+        EscDispatch,
+        CsiDispatch,
+        Hook,
+        Put,
+        Unhook,
+        OscStart,
+        OscPut,
+        OscEnd,
+        Ignore
+    };
+
+    struct TransitionTable; // [state][byte] -> action | next state, built at compile time
+    static const TransitionTable transitions;
+
+    void perform(Action action, unsigned char byte);
+    void enter(State next, unsigned char byte);
+    void leave(unsigned char byte);
+
+    AnsiHandler *handler;
+    State currentState;
+    int params[MaxParams];
+    int paramCount; // Number of parameters started so far (0 means none seen)
+    char privateMarker;
+    char intermediates[MaxIntermediates];
+    int intermediateCount;
+    char dcsFinalByte; // Final byte of the DCS introducer once hooked
+    std::string stringBuffer; // Payload of the current OSC/DCS string
+};
+
+#endif // ANSIPARSER_H
@@ -0,0 +1,93 @@
+// ByteRing.cpp
+#include "ByteRing.h"
+
+#include <algorithm> // std::min
+#include <cstring> // memcpy
+#include <unistd.h> // read
+#include <cerrno> // Distinguishes EAGAIN from real errors
+#include <cstdio> // perror
+
+static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+ByteRing::ByteRing(size_t initialCapacity, size_t maxCapacity) : cap(roundUpToPowerOfTwo(initialCapacity)), maxCap(std::max(cap, roundUpToPowerOfTwo(maxCapacity))), head(0), tail(0) {
+    buffer.reset(new char[cap]);
+}
+
+ByteRing::Span ByteRing::writeSpan() {
+    size_t offset = tail & (cap - 1);
+    size_t toEnd = cap - offset;
+    return Span{buffer.get() + offset, std::min(toEnd, freeSpace())};
+}
+
+void ByteRing::commit(size_t count) {
+    tail += count;
+}
+
+ByteRing::Span ByteRing::readSpan() const {
+    size_t offset = head & (cap - 1);
+    size_t toEnd = cap - offset;
+    return Span{buffer.get() + offset, std::min(toEnd, size())};
+}
+
+void ByteRing::consume(size_t count) {
+    head += count;
+    if (head == tail) {
+        head = tail = 0; // Rewind so the next drain gets one contiguous span
+    }
+}
+
+bool ByteRing::grow() {
+    if (cap >= maxCap) {
+        return false;
+    }
+    size_t newCap = cap * 2;
+    std::unique_ptr<char[]> grown(new char[newCap]);
+
+    // Unwrap the contents to the start of the new storage
+    size_t used = size();
+    size_t copied = 0;
+    while (copied < used) {
+        Span span = readSpan();
+        memcpy(grown.get() + copied, span.data, span.size);
+        copied += span.size;
+        head += span.size;
+    }
+    buffer = std::move(grown);
+    cap = newCap;
+    head = 0;
+    tail = used;
+    return true;
+}
+
+ByteRing::FillResult ByteRing::fillFrom(int fd, size_t &reads, size_t &bytes) {
+    for (;;) {
+        if (isFull() && !grow()) {
+            return Full;
+        }
+        Span span = writeSpan();
+        ssize_t count = ::read(fd, span.data, span.size);
+
+        if (count > 0) {
+            commit(size_t(count));
+            ++reads;
+            bytes += size_t(count);
+        } else if (count == 0) {
+            return EndOfFile;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return Drained;
+        } else {
+            if (errno != EIO) { // EIO means the other side of the PTY was closed
+                perror("read");
+            }
+            return EndOfFile;
+        }
+    }
+}
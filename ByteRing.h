@@ -0,0 +1,59 @@
+// ByteRing.h
+
+#ifndef BYTERING_H
+#define BYTERING_H
+
+#include <cstddef> // size_t
+#include <memory> // std::unique_ptr for the storage
+
+/**
+ * @file ByteRing.h
+ * @brief Growable single-threaded ring buffer used to stage raw PTY output.
+ *
+ * The PTY is drained straight into the free space returned by writeSpan(), and the
+ * parser consumes the data in place through readSpan(), so bytes are never copied on
+ * the way in or out. The capacity is always a power of two and only grows when the
+ * buffer is full, up to the limit passed to the constructor.
+ */
+class ByteRing {
+public:
+    struct Span {
+        char *data;
+        size_t size;
+    };
+
+    // Why fillFrom() stopped reading
+    enum FillResult {
+        Drained, // The descriptor would block
+        Full, // The buffer reached its capacity limit; more data may be waiting
+        EndOfFile // EOF or an error; for a PTY master, EIO once the shell is gone
+    };
+
+    explicit ByteRing(size_t initialCapacity = 64 * 1024, size_t maxCapacity = 1024 * 1024);
+
+    Span writeSpan(); // Largest contiguous free region; may be smaller than freeSpace()
+    void commit(size_t count); // Marks count bytes of the last writeSpan() as filled
+    Span readSpan() const; // Largest contiguous filled region
+    void consume(size_t count); // Releases count bytes from the front
+
+    bool grow(); // Doubles the capacity if below the limit, keeping the contents
+
+    // Reads a non-blocking descriptor into the free space, growing as needed, until it
+    // would block; adds the number of read() calls and bytes to reads and bytes
+    FillResult fillFrom(int fd, size_t &reads, size_t &bytes);
+    void clear() { head = tail = 0; }
+
+    size_t size() const { return tail - head; }
+    size_t capacity() const { return cap; }
+    size_t freeSpace() const { return cap - size(); }
+    bool isEmpty() const { return head == tail; }
+    bool isFull() const { return size() == cap; }
+
+private:
+    std::unique_ptr<char[]> buffer;
+    size_t cap; // Always a power of two
+    size_t maxCap;
+    size_t head, tail; // Free running offsets, masked with cap - 1 on access
+};
+
+#endif // BYTERING_H
@@ -8,19 +8,76 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Hot path counters, timers, the Ctrl+Shift+I overlay and TERME_TRACE export:
+# qmake CONFIG+=instrumentation. Without it the probes compile to nothing.
+instrumentation {
+    DEFINES += TERME_INSTRUMENTATION
+}
+
 SOURCES += \
+    AnsiParser.cpp \
+    ByteRing.cpp \
+    GlyphAtlas.cpp \
+    InputWriter.cpp \
+    Instrumentation.cpp \
+    PtyChannel.cpp \
+    PtyReactor.cpp \
+    RenderScheduler.cpp \
+    Scrollback.cpp \
+    ScrollbackPool.cpp \
+    ScrollbackSearch.cpp \
+    SearchBar.cpp \
+    SessionManager.cpp \
+    ShellLauncher.cpp \
+    StatsOverlay.cpp \
     TerminalEmulator.cpp \
+    TerminalScreen.cpp \
+    TerminalView.cpp \
+    TextSearch.cpp \
     main.cpp
 
 TARGET = TerminalEmulatorApp
 TEMPLATE = app
 
 LIBS += -lvterm
+LIBS += -lz # Scrollback page compression
+
+# Headless PTY throughput and latency benchmark (make termE). The read path workloads
+# use only the Qt-free parser, screen model and scrollback; --paste-check also runs the
+# reactor classes, so those are built in with Qt Core and their moc output
+BENCH_SOURCES = termE.cpp AnsiParser.cpp ByteRing.cpp InputWriter.cpp Instrumentation.cpp PtyChannel.cpp PtyReactor.cpp Scrollback.cpp ScrollbackPool.cpp TerminalScreen.cpp
+BENCH_MOC = moc_InputWriter.cpp moc_PtyChannel.cpp moc_PtyReactor.cpp
+BENCH_FILES = $$join(BENCH_SOURCES, " $$PWD/", "$$PWD/")
+termE.target = termE
+termE.depends = $$BENCH_FILES $$BENCH_MOC
+termE.commands = $(CXX) $(CXXFLAGS) -O2 $(DEFINES) $(INCPATH) -o termE $$BENCH_FILES $$BENCH_MOC $(LIBS) -lutil
+QMAKE_EXTRA_TARGETS += termE
 
 
 HEADERS += \
+    AnsiParser.h \
+    ByteRing.h \
     CustomLineEdit.h \
-    TerminalEmulator.h
+    GlyphAtlas.h \
+    InputWriter.h \
+    Instrumentation.h \
+    PtyChannel.h \
+    PtyReactor.h \
+    RenderScheduler.h \
+    Scrollback.h \
+    ScrollbackPool.h \
+    ScrollbackSearch.h \
+    SearchBar.h \
+    SessionManager.h \
+    ShellLauncher.h \
+    SpscQueue.h \
+    StartupTrace.h \
+    StatsOverlay.h \
+    TerminalEmulator.h \
+    TerminalScreen.h \
+    TerminalView.h \
+    TextSearch.h \
+    Utf8Decoder.h
 
 
 FORMS += \
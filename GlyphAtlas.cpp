@@ -0,0 +1,79 @@
+// GlyphAtlas.cpp
+#include "GlyphAtlas.h"
+
+#include <QPainter> //Rasterises glyphs into the atlas pages.
+#include <QtMath> //qCeil for page sizes.
+
+GlyphAtlas::GlyphAtlas(const QFont &font, int cellWidth, int cellHeight, int ascent) : cellWidth(cellWidth), cellHeight(cellHeight), ascent(ascent) {
+    for (int style = 0; style < 4; ++style) {
+        fonts[style] = font;
+        fonts[style].setBold(style & Bold);
+        fonts[style].setItalic(style & Italic);
+    }
+}
+
+void GlyphAtlas::beginFrame() {
+    // Direct colours can fill the atlas with one-off glyphs; start over between frames
+    // rather than evicting glyphs a frame in progress may still refer to
+    if (int(pages.size()) > MaxPages || (int(pages.size()) == MaxPages && pages.back().nextY + cellHeight > PageSize)) {
+        glyphs.clear();
+        pages.clear();
+    }
+}
+
+GlyphAtlas::Glyph GlyphAtlas::glyph(uint32_t codepoint, uint16_t style, QRgb color, int span, qreal ratio) {
+    // 21 bits of codepoint, 2 style bits, 24 bits of colour, the span and the pixel
+    // ratio in hundredths
+    const quint64 ratioKey = quint64(qBound(1, qRound(ratio * 100), 0xFFFF));
+    quint64 key = quint64(codepoint & 0x1FFFFF) | quint64(style & 3) << 21 | quint64(color & 0xFFFFFF) << 23 | quint64(span > 1) << 47 | ratioKey << 48;
+    auto it = glyphs.find(key);
+    if (it == glyphs.end()) {
+        it = glyphs.insert(key, Glyph{0, QRectF()});
+        rasterise(it.value(), codepoint, style, color, span, qreal(ratioKey) / 100);
+    }
+    return it.value();
+}
+
+void GlyphAtlas::rasterise(Glyph &glyph, uint32_t codepoint, uint16_t style, QRgb color, int span, qreal ratio) {
+    int slotWidth = cellWidth * span;
+
+    // Shelf packing on the newest page of this ratio: all slots are one cell high, so
+    // rows of slots fill each page
+    int index = int(pages.size()) - 1;
+    while (index >= 0 && pages[size_t(index)].ratio != ratio) {
+        --index;
+    }
+    if (index >= 0) {
+        Page &last = pages[size_t(index)];
+        if (last.nextX + slotWidth > PageSize) {
+            last.nextX = 0;
+            last.nextY += cellHeight;
+        }
+        if (last.nextY + cellHeight > PageSize) {
+            index = -1;
+        }
+    }
+    if (index < 0) {
+        // Sized in device pixels, so glyphs are rasterised at the screen's resolution
+        const int pixels = qCeil(PageSize * ratio);
+        Page page = {QPixmap(pixels, pixels), ratio, 0, 0};
+        page.pixmap.setDevicePixelRatio(ratio);
+        page.pixmap.fill(Qt::transparent);
+        pages.push_back(page);
+        index = int(pages.size()) - 1;
+    }
+
+    Page &page = pages[size_t(index)];
+    QRect slot(page.nextX, page.nextY, slotWidth, cellHeight);
+    page.nextX += slotWidth;
+
+    QPainter painter(&page.pixmap); // Device independent coordinates
+    painter.setClipRect(slot);
+    painter.setFont(fonts[style & 3]);
+    painter.setPen(QColor::fromRgb(color));
+    char32_t cp = codepoint;
+    painter.drawText(slot.left(), slot.top() + ascent, QString::fromUcs4(&cp, 1));
+
+    glyph.page = index;
+    glyph.source = QRectF(slot.x() * ratio, slot.y() * ratio, slot.width() * ratio, slot.height() * ratio);
+}
@@ -0,0 +1,68 @@
+// GlyphAtlas.h
+
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <QFont> // Font the glyphs are rasterised with
+#include <QHash> // Glyph lookup by key
+#include <QPixmap> // Atlas pages
+#include <QRectF> // Glyph location within a page
+#include <QRgb> // Glyph colour
+#include <vector>
+
+/**
+ * @file GlyphAtlas.h
+ * @brief Cache of pre-rasterised glyphs packed into a few large pixmaps.
+ *
+ * Each glyph is rendered once per (codepoint, bold/italic, colour) into a cell-sized
+ * slot of an atlas page. A row is then drawn as runs of cells sharing a style, each
+ * run being a single QPainter::drawPixmapFragments() call that blits all its glyphs
+ * from one page, instead of a text layout per character.
+ *
+ * Glyphs are rasterised at the device pixel ratio of the screen they are drawn on, into
+ * pages of that ratio, and the ratio is part of the cache key: a window moved to a
+ * screen with another scale factor gets sharp glyphs rasterised for it, and views on
+ * different screens can share one atlas.
+ */
+class GlyphAtlas {
+public:
+    enum Style : uint16_t {
+        Bold = 1 << 0,
+        Italic = 1 << 1
+    };
+
+    struct Glyph {
+        int page; // Index of the atlas page holding the glyph
+        QRectF source; // Slot within the page, in device pixels
+    };
+
+    GlyphAtlas(const QFont &font, int cellWidth, int cellHeight, int ascent);
+
+    // Looks the glyph up, rasterising it on first use; span is 2 for wide characters and
+    // ratio the device pixel ratio of the paint device it will be drawn on
+    Glyph glyph(uint32_t codepoint, uint16_t style, QRgb color, int span, qreal ratio);
+    const QPixmap &page(int index) const { return pages[size_t(index)].pixmap; }
+
+    void beginFrame(); // Drops every glyph once the atlas grew past its page budget
+    int glyphCount() const { return int(glyphs.size()); }
+    int pageCount() const { return int(pages.size()); }
+
+private:
+    static constexpr int PageSize = 1024; // Device independent pixels per side of an atlas page
+    static constexpr int MaxPages = 8;
+
+    struct Page {
+        QPixmap pixmap; // PageSize * ratio device pixels per side
+        qreal ratio;
+        int nextX, nextY; // Next free slot, device independent
+    };
+
+    void rasterise(Glyph &glyph, uint32_t codepoint, uint16_t style, QRgb color, int span, qreal ratio);
+
+    QFont fonts[4]; // Indexed by Style bits
+    int cellWidth, cellHeight, ascent;
+    std::vector<Page> pages;
+    QHash<quint64, Glyph> glyphs;
+};
+
+#endif // GLYPHATLAS_H
@@ -0,0 +1,71 @@
+// InputWriter.cpp
+#include "InputWriter.h"
+
+#include "PtyChannel.h" //Command queue to the reactor thread.
+#include "Instrumentation.h" //Backlog gauge.
+
+InputWriter::InputWriter(PtyChannel *channel, QObject *parent) : QObject(parent), channel(nullptr), offset(0) {
+    setChannel(channel);
+}
+
+InputWriter::~InputWriter() {
+    TERME_COUNT(InputBacklog, -pendingBytes());
+}
+
+void InputWriter::setChannel(PtyChannel *newChannel) {
+    channel = newChannel;
+    if (channel) {
+        connect(channel, &PtyChannel::inputSpace, this, &InputWriter::flush, Qt::QueuedConnection);
+        flush();
+    }
+}
+
+void InputWriter::write(const QByteArray &data) {
+    TERME_COUNT(InputBacklog, data.size());
+    backlog += data;
+    flush();
+}
+
+void InputWriter::paste(const QString &text, bool bracketed) {
+    QByteArray data = text.toUtf8();
+
+    // Terminals paste line breaks as Enter, which sends CR
+    data.replace("\r\n", "\r");
+    data.replace('\n', '\r');
+
+    if (bracketed) {
+        // A pasted end marker would let the rest of the text run as typed commands. Taking
+        // one out can join the bytes around it into another, so repeat until none is left
+        while (data.contains("\033[201~")) {
+            data.replace("\033[201~", "");
+        }
+        data.prepend("\033[200~");
+        data.append("\033[201~");
+    }
+    write(data);
+}
+
+void InputWriter::flush() {
+    while (channel && offset < backlog.size()) {
+        qsizetype size = qMin<qsizetype>(backlog.size() - offset, ChunkSize);
+        const char *chunk = backlog.constData() + offset;
+        if (!channel->postInput(chunk, size_t(size))) {
+            // Ask for inputSpace() before trying again, so a queue drained in between
+            // is either caught by the retry or still reported
+            channel->waitForInputSpace();
+            if (!channel->postInput(chunk, size_t(size))) {
+                break;
+            }
+        }
+        offset += size;
+        TERME_COUNT(InputBacklog, -size);
+    }
+
+    if (offset == backlog.size()) {
+        backlog.clear();
+        offset = 0;
+    } else if (offset >= ChunkSize * 16) {
+        backlog.remove(0, offset); // Release what has been sent once a long paste is under way
+        offset = 0;
+    }
+}
@@ -0,0 +1,45 @@
+// InputWriter.h
+
+#ifndef INPUTWRITER_H
+#define INPUTWRITER_H
+
+#include <QObject> // Base class for signals and slots
+#include <QByteArray> // Bytes waiting for the shell
+#include <QString> // Pasted text
+
+class PtyChannel;
+
+/**
+ * @file InputWriter.h
+ * @brief GUI side input queue in front of a session's PtyChannel.
+ *
+ * Everything the user sends to the shell goes through write() or paste(). Bytes are
+ * handed to the session's PtyChannel in chunks of at most ChunkSize; when its command
+ * queue is full (the shell is not reading and the PTY buffer has filled up) the rest
+ * stays here and is sent from inputSpace(), so a multi-megabyte paste neither blocks
+ * the event loop nor loses or reorders bytes.
+ */
+class InputWriter : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int ChunkSize = 64 * 1024;
+
+    explicit InputWriter(PtyChannel *channel, QObject *parent = nullptr); // channel may be set later
+    ~InputWriter() override;
+    void setChannel(PtyChannel *channel); // Starts sending what was queued so far
+
+    void write(const QByteArray &data); // Queues raw bytes, e.g. a key press
+    void paste(const QString &text, bool bracketed); // Queues text the way a terminal pastes it
+
+    qint64 pendingBytes() const { return backlog.size() - offset; } // Not yet accepted by the channel
+
+private slots:
+    void flush(); // Hands as much of the backlog as possible to the channel
+
+private:
+    PtyChannel *channel;
+    QByteArray backlog;
+    qsizetype offset; // Start of the unsent part of backlog
+};
+
+#endif // INPUTWRITER_H
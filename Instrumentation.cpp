@@ -0,0 +1,118 @@
+// Instrumentation.cpp
+#include "Instrumentation.h"
+
+#include <cstdio> //Trace file output.
+#include <memory> //Per-thread trace buffers.
+#include <mutex> //Guards the buffer list and each buffer.
+#include <string>
+#include <vector>
+
+std::atomic<int64_t> Instrumentation::counters[CounterCount] = {};
+std::atomic<uint64_t> Instrumentation::phaseCounts[PhaseCount] = {};
+std::atomic<uint64_t> Instrumentation::phaseNanoseconds[PhaseCount] = {};
+std::atomic<bool> Instrumentation::traceEnabled(false);
+
+namespace {
+
+struct TraceEvent {
+    uint8_t phase;
+    uint64_t startNs; // Since traceOrigin
+    uint64_t durationNs;
+};
+
+// Events of one thread. The owning thread appends under the buffer's own lock, which
+// is only ever contended while the trace is being written
+struct TraceBuffer {
+    static constexpr size_t MaxEvents = 1 << 20;
+
+    std::mutex mutex;
+    int threadId = 0;
+    std::string name;
+    std::vector<TraceEvent> events;
+    size_t dropped = 0;
+};
+
+std::mutex buffersMutex;
+std::vector<std::unique_ptr<TraceBuffer>> buffers; // Kept until exit; threads are few
+const std::chrono::steady_clock::time_point traceOrigin = std::chrono::steady_clock::now();
+
+TraceBuffer &threadBuffer() {
+    thread_local TraceBuffer *buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.emplace_back(new TraceBuffer);
+        buffer = buffers.back().get();
+        buffer->threadId = int(buffers.size());
+    }
+    return *buffer;
+}
+
+} // namespace
+
+Instrumentation::PhaseTotals Instrumentation::totals(Phase phase) {
+    PhaseTotals result;
+    result.count = phaseCounts[phase].load(std::memory_order_relaxed);
+    result.nanoseconds = phaseNanoseconds[phase].load(std::memory_order_relaxed);
+    return result;
+}
+
+const char *Instrumentation::phaseName(Phase phase) {
+    static const char *names[PhaseCount] = {"read", "parse", "write", "apply", "render"};
+    return names[phase];
+}
+
+void Instrumentation::nameThread(const char *name) {
+    TraceBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void Instrumentation::startTrace() {
+    traceEnabled.store(true);
+}
+
+void Instrumentation::finish(Phase phase, std::chrono::steady_clock::time_point start) {
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    phaseCounts[phase].fetch_add(1, std::memory_order_relaxed);
+    phaseNanoseconds[phase].fetch_add(ns, std::memory_order_relaxed);
+
+    if (tracing()) {
+        TraceBuffer &buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() < TraceBuffer::MaxEvents) {
+            uint64_t offset = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(start - traceOrigin).count());
+            buffer.events.push_back(TraceEvent{uint8_t(phase), offset, ns});
+        } else {
+            ++buffer.dropped;
+        }
+    }
+}
+
+bool Instrumentation::writeTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+    bool first = true;
+    std::lock_guard<std::mutex> listLock(buffersMutex);
+    for (const std::unique_ptr<TraceBuffer> &buffer : buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        if (!buffer->name.empty()) {
+            // Names in the buffer come from string literals in the code, no escaping needed
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", buffer->threadId, buffer->name.c_str());
+            first = false;
+        }
+        for (const TraceEvent &event : buffer->events) {
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n", phaseName(Phase(event.phase)), buffer->threadId, double(event.startNs) / 1e3, double(event.durationNs) / 1e3);
+            first = false;
+        }
+        if (buffer->dropped) {
+            fprintf(stderr, "trace: %zu events of thread %d dropped\n", buffer->dropped, buffer->threadId);
+        }
+    }
+    fputs("\n]}\n", file);
+    return fclose(file) == 0;
+}
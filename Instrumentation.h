@@ -0,0 +1,97 @@
+// Instrumentation.h
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic> // Counters shared by the GUI and reactor threads
+#include <chrono> // Scoped timer clock
+#include <cstdint>
+
+/**
+ * @file Instrumentation.h
+ * @brief Counters and scoped timers on the read, parse, write, apply and render paths.
+ *
+ * Built in only with CONFIG += instrumentation (which defines TERME_INSTRUMENTATION);
+ * otherwise TERME_COUNT, TERME_SCOPE and TERME_THREAD_NAME expand to nothing and the
+ * hot paths carry no trace of them. When built in, counters are relaxed atomics and a
+ * scope costs two clock reads and two atomic adds. Setting TERME_TRACE=<file> at startup
+ * additionally records every timed scope as a Chrome trace event (chrome://tracing,
+ * Perfetto) and writes the file on exit. StatsOverlay shows the live numbers.
+ */
+class Instrumentation {
+public:
+#ifdef TERME_INSTRUMENTATION
+    static constexpr bool compiledIn = true;
+#else
+    static constexpr bool compiledIn = false;
+#endif
+
+    enum Counter {
+        BytesRead, // From the PTYs
+        BytesParsed,
+        BytesWritten, // To the PTYs
+        UpdatesPublished, // ScreenUpdates handed to the GUI
+        FramesPainted, // TerminalView paint events
+        InputBacklog, // Gauge: bytes held by InputWriters
+        PendingWrite, // Gauge: bytes accepted by channels but not yet written
+        CounterCount
+    };
+
+    enum Phase {
+        Read,
+        Parse,
+        Write,
+        Apply, // GUI thread taking updates into its screen copy
+        Render,
+        PhaseCount
+    };
+
+    struct PhaseTotals {
+        uint64_t count = 0;
+        uint64_t nanoseconds = 0;
+    };
+
+    static void add(Counter counter, int64_t amount) { counters[counter].fetch_add(amount, std::memory_order_relaxed); }
+    static int64_t value(Counter counter) { return counters[counter].load(std::memory_order_relaxed); }
+    static PhaseTotals totals(Phase phase);
+    static const char *phaseName(Phase phase);
+
+    static void nameThread(const char *name); // Labels the calling thread in the trace
+    static void startTrace(); // Begins recording trace events
+    static bool tracing() { return traceEnabled.load(std::memory_order_relaxed); }
+    static bool writeTrace(const char *path); // Chrome trace JSON of everything recorded so far
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() { finish(phase, start); }
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    static void finish(Phase phase, std::chrono::steady_clock::time_point start);
+
+    static std::atomic<int64_t> counters[CounterCount];
+    static std::atomic<uint64_t> phaseCounts[PhaseCount];
+    static std::atomic<uint64_t> phaseNanoseconds[PhaseCount];
+    static std::atomic<bool> traceEnabled;
+};
+
+#ifdef TERME_INSTRUMENTATION
+#define TERME_CONCAT_(a, b) a##b
+#define TERME_CONCAT(a, b) TERME_CONCAT_(a, b)
+#define TERME_COUNT(counter, amount) Instrumentation::add(Instrumentation::counter, int64_t(amount))
+#define TERME_SCOPE(phase) Instrumentation::ScopedTimer TERME_CONCAT(termeScope, __LINE__)(Instrumentation::phase)
+#define TERME_THREAD_NAME(name) Instrumentation::nameThread(name)
+#else
+#define TERME_COUNT(counter, amount) do {} while (false)
+#define TERME_SCOPE(phase) do {} while (false)
+#define TERME_THREAD_NAME(name) do {} while (false)
+#endif
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,182 @@
+// PtyChannel.cpp
+#include "PtyChannel.h"
+
+#include "PtyReactor.h" // Wakes the reactor when commands are posted
+#include "ByteRing.h" // Staging buffer shared by all channels
+#include "Scrollback.h" // Encodes scrolled out rows
+#include "Instrumentation.h" // Read, parse and write timers
+#include <unistd.h> //write() on the PTY.
+#include <sys/ioctl.h> //Window size changes.
+#include <termios.h> //struct winsize.
+#include <cerrno> //Distinguishes EAGAIN from real errors.
+#include <cstdio> //perror.
+
+// Scrolled out lines kept while the GUI is not picking up updates
+static constexpr size_t MaxPendingHistory = 100000;
+
+PtyChannel::PtyChannel(PtyReactor *reactor, int masterFd, int columns, int rows) : QObject(reactor), reactor(reactor), masterFd(masterFd), notifyPending(false), inputWaiting(false), requestedSize(0), screen(columns, rows), parser(&screen), writeOffset(0), bytesSincePublish(0), eof(false), eofPublished(false), registered(false), writeInterest(false), commands(64), spareInput(64), updates(2), spareUpdates(2) {
+    screen.onLineScrolledOut = [this](const Cell *cells, int count) {
+        if (pendingHistoryEnds.size() >= MaxPendingHistory) {
+            // Drop the older half; both buffers keep their capacity
+            const size_t kept = MaxPendingHistory / 2;
+            const size_t cut = pendingHistoryEnds[kept - 1];
+            pendingHistory.erase(0, cut);
+            pendingHistoryEnds.erase(pendingHistoryEnds.begin(), pendingHistoryEnds.begin() + kept);
+            for (size_t &end : pendingHistoryEnds) {
+                end -= cut;
+            }
+        }
+        Scrollback::encodeCells(cells, count, pendingHistory);
+        pendingHistoryEnds.push_back(pendingHistory.size());
+    };
+}
+
+bool PtyChannel::postInput(const char *data, size_t size) {
+    if (inputChunk.capacity() < size) {
+        spareInput.tryPop(inputChunk); // A buffer the reactor is done with
+    }
+    inputChunk.assign(data, size);
+    if (!commands.tryPush(std::move(inputChunk))) {
+        return false; // inputChunk still holds the bytes and its buffer
+    }
+    reactor->wake();
+    return true;
+}
+
+void PtyChannel::postResize(int columns, int rows) {
+    requestedSize.store(quint32(qBound(1, columns, 0xFFFF)) << 16 | quint32(qBound(1, rows, 0xFFFF)));
+    reactor->wake();
+}
+
+bool PtyChannel::takeUpdate(ScreenUpdate &update) {
+    if (updates.isEmpty()) {
+        return false;
+    }
+    // The caller is done with the previous update, so publish() can refill its buffers.
+    // It is handed back first: publish() waits for the queue to empty, and by then the
+    // spare must already be there
+    spareUpdates.tryPush(std::move(update));
+    updates.tryPop(update); // Only this thread pops, so the update is still there
+    return true;
+}
+
+void PtyChannel::processCommands() {
+    if (quint32 request = requestedSize.exchange(0)) {
+        int columns = int(request >> 16), rows = int(request & 0xFFFF);
+        screen.resize(columns, rows);
+        struct winsize size = {};
+        size.ws_col = static_cast<unsigned short>(columns);
+        size.ws_row = static_cast<unsigned short>(rows);
+        if (ioctl(masterFd, TIOCSWINSZ, &size) == -1) { // Delivers SIGWINCH to the shell
+            perror("ioctl TIOCSWINSZ");
+        }
+        ++bytesSincePublish; // Force an update carrying the new size
+    }
+
+    std::string input;
+    bool taken = false;
+    while (pendingBytes() < MaxPendingWrite && commands.tryPop(input)) {
+        taken = true;
+        TERME_COUNT(PendingWrite, input.size());
+        pendingWrite += input;
+        input.clear();
+        spareInput.tryPush(std::move(input)); // postInput() copies the next chunk into it
+    }
+    if (taken && inputWaiting.exchange(false)) {
+        emit inputSpace();
+    }
+}
+
+quint64 PtyChannel::drainMaster(ByteRing &readBuffer, quint64 &reads) {
+    // Drain everything the PTY has buffered, up to the ring buffer's limit; if it fills
+    // up, epoll reports the rest on the next pass. The buffer is shared by all channels
+    // and always handed back empty
+    size_t readCalls = 0, bytes = 0;
+    {
+        TERME_SCOPE(Read);
+        if (readBuffer.fillFrom(masterFd, readCalls, bytes) == ByteRing::EndOfFile) {
+            eof = true;
+        }
+    }
+    reads += readCalls;
+    TERME_COUNT(BytesRead, bytes);
+
+    {
+        TERME_SCOPE(Parse);
+        while (!readBuffer.isEmpty()) {
+            ByteRing::Span span = readBuffer.readSpan();
+            parser.feed(span.data, span.size);
+            readBuffer.consume(span.size);
+        }
+    }
+    TERME_COUNT(BytesParsed, bytes);
+    bytesSincePublish += bytes;
+
+    // Replies to terminal queries (cursor position reports and the like)
+    std::string responses = screen.takeResponses();
+    TERME_COUNT(PendingWrite, responses.size());
+    pendingWrite += responses;
+    return bytes;
+}
+
+void PtyChannel::flushWrites() {
+    if (!wantsWrite()) {
+        return;
+    }
+    TERME_SCOPE(Write);
+    size_t written = 0;
+    while (writeOffset + written < pendingWrite.size()) {
+        ssize_t count = write(masterFd, pendingWrite.data() + writeOffset + written, pendingWrite.size() - writeOffset - written);
+        if (count > 0) {
+            written += size_t(count);
+        } else if (count == -1 && errno == EINTR) {
+            continue;
+        } else {
+            if (count == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("write failed");
+                written = pendingWrite.size() - writeOffset; // The shell is gone; drop the input
+            }
+            break; // PTY input buffer full; EPOLLOUT resumes the write
+        }
+    }
+    writeOffset += written;
+
+    // The PTY takes a few KiB per write, so moving the rest down each time would copy a
+    // large paste over and over; the written part is only dropped once it is large
+    if (writeOffset == pendingWrite.size()) {
+        pendingWrite.clear();
+        writeOffset = 0;
+    } else if (writeOffset >= MaxPendingWrite) {
+        pendingWrite.erase(0, writeOffset);
+        writeOffset = 0;
+    }
+    TERME_COUNT(BytesWritten, written);
+    TERME_COUNT(PendingWrite, -int64_t(written));
+}
+
+void PtyChannel::publish() {
+    if (!damagePending()) {
+        return;
+    }
+    if (!updates.isEmpty()) {
+        return; // The GUI has not taken the last update yet; keep merging damage
+    }
+
+    ScreenUpdate update;
+    spareUpdates.tryPop(update); // Reuses the buffers of one the GUI has applied
+    screen.takeUpdate(update);
+    update.history.swap(pendingHistory);
+    update.historyEnds.swap(pendingHistoryEnds);
+    pendingHistory.clear();
+    pendingHistoryEnds.clear();
+    update.bytes = bytesSincePublish;
+    update.eof = eof;
+    updates.tryPush(std::move(update));
+    TERME_COUNT(UpdatesPublished, 1);
+    bytesSincePublish = 0;
+    eofPublished = eof;
+
+    if (!notifyPending.exchange(true)) {
+        emit updatesAvailable();
+    }
+}
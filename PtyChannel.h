@@ -0,0 +1,95 @@
+// PtyChannel.h
+
+#ifndef PTYCHANNEL_H
+#define PTYCHANNEL_H
+
+#include <QObject> // Signals to the session's widgets
+#include <QByteArray> // Input bytes
+#include <atomic> // Wakeup coalescing flags
+#include <string>
+#include <vector>
+#include "AnsiParser.h" // Parsing happens on the reactor thread
+#include "SpscQueue.h" // Lock-free handoff to and from the GUI thread
+#include "TerminalScreen.h" // Back buffer the parser writes into
+
+class ByteRing;
+class PtyReactor;
+
+/**
+ * @file PtyChannel.h
+ * @brief One session's master PTY as served by the shared PtyReactor thread.
+ *
+ * The reactor drains the PTY, runs the parser into the channel's own TerminalScreen and
+ * publishes the damaged rows as a ScreenUpdate through a lock-free SPSC queue. At most
+ * one update is outstanding; while the GUI is busy painting, further output keeps being
+ * parsed and its damage is merged into the next update, so the shell never waits for a
+ * repaint. Input travels the other way through a second SPSC queue; a resize is just
+ * the latest requested size, so window drags coalesce and never wait behind a paste.
+ * Writes to the PTY never block: bytes the shell has not taken yet wait for EPOLLOUT,
+ * and once MaxPendingWrite bytes are waiting the channel stops taking commands, so a
+ * large paste backs up into the caller instead of into memory. A caller that found the
+ * queue full calls waitForInputSpace() and gets inputSpace() once commands are being
+ * taken again.
+ *
+ * Buffers travel back once used: the GUI returns each update it has applied and the
+ * reactor returns each input chunk it has copied, so once the buffers have grown to
+ * the session's needs, reading, parsing and publishing allocate nothing.
+ *
+ * Channels are created and destroyed through PtyReactor::open() and close().
+ */
+class PtyChannel : public QObject {
+    Q_OBJECT
+public:
+    static constexpr size_t MaxPendingWrite = 256 * 1024; // Unwritten bytes before commands are held back
+
+    // GUI thread side
+    bool postInput(const char *data, size_t size); // Queues bytes for the shell; false if the queue is full
+    bool postInput(const QByteArray &data) { return postInput(data.constData(), size_t(data.size())); }
+    void postResize(int columns, int rows);
+    void waitForInputSpace() { inputWaiting.store(true); } // Requests inputSpace() once the queue drains
+    bool takeUpdate(ScreenUpdate &update); // Swaps in the next published update, if any; the old one is reused
+    void acknowledgeUpdates() { notifyPending.store(false, std::memory_order_release); }
+
+signals:
+    // Emitted from the reactor thread; connect with a queued connection
+    void updatesAvailable();
+    void inputSpace(); // The command queue is being drained again after waitForInputSpace()
+
+private:
+    friend class PtyReactor;
+
+    PtyChannel(PtyReactor *reactor, int masterFd, int columns, int rows);
+
+    // Reactor thread side
+    void processCommands();
+    quint64 drainMaster(ByteRing &readBuffer, quint64 &reads); // Returns the number of bytes read
+    void flushWrites();
+    void publish();
+    bool damagePending() const { return bytesSincePublish > 0 || (eof && !eofPublished); }
+    size_t pendingBytes() const { return pendingWrite.size() - writeOffset; } // Accepted but not yet written
+    bool wantsWrite() const { return pendingBytes() > 0; }
+
+    PtyReactor *reactor;
+    int masterFd;
+    std::atomic<bool> notifyPending; // An updatesAvailable() signal is on its way
+    std::atomic<bool> inputWaiting; // The GUI is holding input back until inputSpace()
+    std::atomic<quint32> requestedSize; // columns << 16 | rows of a pending resize, or 0
+
+    TerminalScreen screen;
+    AnsiParser parser;
+    std::string pendingWrite; // Bytes accepted for the shell; the PTY has taken those before writeOffset
+    size_t writeOffset;
+    std::string pendingHistory; // Lines scrolled out since the last update, back to back
+    std::vector<size_t> pendingHistoryEnds; // End of each line in pendingHistory
+    size_t bytesSincePublish;
+    bool eof, eofPublished;
+    bool registered, writeInterest; // State of the fd in the reactor's epoll set
+
+    SpscQueue<std::string> commands; // Input, GUI -> reactor; short, InputWriter holds any overflow
+    SpscQueue<std::string> spareInput; // Copied input buffers, reactor -> GUI
+    std::string inputChunk; // GUI side: buffer for the next command
+    SpscQueue<ScreenUpdate> updates; // Reactor -> GUI
+    SpscQueue<ScreenUpdate> spareUpdates; // Applied updates, GUI -> reactor
+};
+
+#endif // PTYCHANNEL_H
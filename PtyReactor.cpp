@@ -0,0 +1,189 @@
+// PtyReactor.cpp
+#include "PtyReactor.h"
+
+#include "Instrumentation.h" //Names the thread in traces.
+
+#include <unistd.h> //close() and the eventfd counter.
+#include <sys/epoll.h> //Readiness of all masters in one call.
+#include <sys/eventfd.h> //Wakeup channel from the GUI thread.
+#include <algorithm> //std::find
+#include <cerrno> //Distinguishes EINTR from real errors.
+#include <cstdio> //perror.
+
+PtyReactor::PtyReactor(QObject *parent) : QThread(parent), epollFd(-1), wakeFd(-1), stopping(false) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) {
+        perror("epoll_create1");
+    }
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd == -1) {
+        perror("eventfd");
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr; // The wakeup fd is the only entry without a channel
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) == -1) {
+        perror("epoll_ctl");
+    }
+}
+
+PtyReactor::~PtyReactor() {
+    stop();
+    applyRequests(); // The thread is gone, so its bookkeeping can be finished here
+    for (PtyChannel *channel : channels) {
+        ::close(channel->masterFd);
+    }
+    // The channels themselves are children and are deleted with the reactor
+    ::close(wakeFd);
+    ::close(epollFd);
+}
+
+void PtyReactor::stop() {
+    stopping.store(true);
+    wake();
+    wait();
+}
+
+void PtyReactor::wake() {
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+PtyChannel *PtyReactor::open(int masterFd, int columns, int rows) {
+    PtyChannel *channel = new PtyChannel(this, masterFd, columns, rows);
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        opened.push_back(channel);
+    }
+    wake();
+    return channel;
+}
+
+void PtyReactor::close(PtyChannel *channel) {
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        closed.push_back(channel);
+    }
+    wake();
+}
+
+void PtyReactor::applyRequests() {
+    std::vector<PtyChannel *> opening, closing;
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        opening.swap(opened);
+        closing.swap(closed);
+    }
+
+    for (PtyChannel *channel : opening) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = channel;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, channel->masterFd, &event) == -1) {
+            perror("epoll_ctl");
+        } else {
+            channel->registered = true;
+        }
+        channels.push_back(channel);
+    }
+
+    for (PtyChannel *channel : closing) {
+        unregister(channel);
+        TERME_COUNT(PendingWrite, -int64_t(channel->pendingBytes()));
+        ::close(channel->masterFd);
+        channels.erase(std::find(channels.begin(), channels.end(), channel));
+        channel->deleteLater(); // Signals already queued for the GUI are discarded with it
+    }
+}
+
+void PtyReactor::unregister(PtyChannel *channel) {
+    if (channel->registered) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, channel->masterFd, nullptr);
+        channel->registered = false;
+    }
+}
+
+void PtyReactor::updateInterest(PtyChannel *channel) {
+    if (channel->eof) {
+        unregister(channel); // A hung up PTY would report EPOLLHUP forever
+        return;
+    }
+    if (channel->writeInterest == channel->wantsWrite()) {
+        return;
+    }
+    channel->writeInterest = channel->wantsWrite();
+    struct epoll_event event = {};
+    event.events = EPOLLIN | (channel->writeInterest ? EPOLLOUT : 0);
+    event.data.ptr = channel;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, channel->masterFd, &event) == -1) {
+        perror("epoll_ctl");
+    }
+}
+
+void PtyReactor::run() {
+    TERME_THREAD_NAME("pty reactor");
+    static constexpr int MaxEvents = 64;
+    struct epoll_event events[MaxEvents];
+
+    while (!stopping.load()) {
+        bool damagePending = false;
+        for (PtyChannel *channel : channels) {
+            damagePending = damagePending || channel->damagePending();
+        }
+
+        // With unpublished damage and a busy GUI, check back shortly instead of sleeping
+        int count = epoll_wait(epollFd, events, MaxEvents, damagePending ? 2 : -1);
+        if (count == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            break;
+        }
+
+        bool woken = false;
+        for (int i = 0; i < count; ++i) {
+            PtyChannel *channel = static_cast<PtyChannel *>(events[i].data.ptr);
+            if (!channel) {
+                woken = true;
+            } else if (!channel->eof && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                quint64 reads = 0;
+                quint64 bytes = channel->drainMaster(readBuffer, reads);
+                ++readStats.wakeups;
+                readStats.reads += reads;
+                readStats.bytes += bytes;
+                readStats.maxReadsPerWakeup = qMax(readStats.maxReadsPerWakeup, reads);
+                readStats.maxBytesPerWakeup = qMax(readStats.maxBytesPerWakeup, bytes);
+            }
+        }
+        if (woken) {
+            uint64_t value;
+            while (read(wakeFd, &value, sizeof(value)) > 0) {
+            }
+            // After the events: a channel closed now may still have had one in this batch
+            applyRequests();
+        }
+
+        // Commands held back by a full write buffer are picked up again once EPOLLOUT has
+        // made room, so every channel is visited on every pass and not only on wakeups
+        for (PtyChannel *channel : channels) {
+            channel->flushWrites();
+            channel->processCommands();
+            channel->flushWrites();
+            updateInterest(channel);
+            channel->publish();
+        }
+    }
+}
+
+QString PtyReactor::ReadStats::summary() const {
+    double perWakeup = wakeups ? 1.0 / double(wakeups) : 0.0;
+    return QString("read stats: %1 wakeups, %2 reads/wakeup (max %3), %4 bytes/wakeup (max %5)")
+        .arg(wakeups)
+        .arg(double(reads) * perWakeup, 0, 'f', 2)
+        .arg(maxReadsPerWakeup)
+        .arg(double(bytes) * perWakeup, 0, 'f', 0)
+        .arg(maxBytesPerWakeup);
+}
@@ -0,0 +1,71 @@
+// PtyReactor.h
+
+#ifndef PTYREACTOR_H
+#define PTYREACTOR_H
+
+#include <QThread> // Base class for the I/O thread
+#include <QString> // Statistics summary
+#include <atomic> // Stop flag
+#include <mutex> // Guards open/close requests
+#include <vector>
+#include "ByteRing.h" // Staging buffer shared by all channels
+#include "PtyChannel.h" // Per-session state served by the reactor
+
+/**
+ * @file PtyReactor.h
+ * @brief Single background thread that serves the master PTYs of all sessions.
+ *
+ * Every session's master is registered with one epoll set, so a hundred idle shells
+ * cost a hundred file descriptors and no threads. On each wakeup the ready channels are
+ * drained into one shared ByteRing and parsed; then every channel takes its queued
+ * commands, flushes its pending writes and publishes its damage. An eventfd wakes the
+ * loop when the GUI posts commands or opens and closes channels.
+ */
+class PtyReactor : public QThread {
+    Q_OBJECT
+public:
+    // Counters for the PTY read path over all channels; updated by the reactor thread only
+    struct ReadStats {
+        quint64 wakeups = 0; // A channel was reported readable
+        quint64 reads = 0; // Successful read() calls
+        quint64 bytes = 0; // Bytes read from the PTYs
+        quint64 maxReadsPerWakeup = 0;
+        quint64 maxBytesPerWakeup = 0;
+
+        QString summary() const;
+    };
+
+    explicit PtyReactor(QObject *parent = nullptr);
+    ~PtyReactor() override; // Stops the thread and closes the remaining masters
+
+    // GUI thread side
+    PtyChannel *open(int masterFd, int columns, int rows); // Takes ownership of the non-blocking masterFd
+    void close(PtyChannel *channel); // Unregisters and closes the master; the channel is deleted later
+    void stop(); // Asks the loop to exit and waits for it
+
+    const ReadStats &readStatistics() const { return readStats; } // Only stable once stopped
+
+protected:
+    void run() override;
+
+private:
+    friend class PtyChannel;
+
+    void wake();
+    void applyRequests(); // Registers opened channels and retires closed ones
+    void updateInterest(PtyChannel *channel);
+    void unregister(PtyChannel *channel);
+
+    int epollFd;
+    int wakeFd; // eventfd signalled by the GUI thread
+    std::atomic<bool> stopping;
+
+    std::mutex requestMutex; // Opening and closing sessions is rare; a lock is fine here
+    std::vector<PtyChannel *> opened, closed;
+
+    std::vector<PtyChannel *> channels; // Reactor thread only
+    ByteRing readBuffer;
+    ReadStats readStats;
+};
+
+#endif // PTYREACTOR_H
@@ -0,0 +1,37 @@
+// RenderScheduler.cpp
+#include "RenderScheduler.h"
+
+RenderScheduler::RenderScheduler(QObject *parent) : QObject(parent), frameInterval(16), backlogThreshold(256 * 1024), maxSkippedFrames(6), backlog(0), skippedInRow(0), rendered(0), skipped(0) {
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer); // Coarse timers may slip by 5%, about a frame at 60 Hz
+    connect(&timer, &QTimer::timeout, this, &RenderScheduler::onTimeout);
+    sinceLastFrame.start();
+}
+
+void RenderScheduler::requestFrame(qint64 bytes) {
+    backlog += bytes;
+    if (timer.isActive()) {
+        return; // A frame is already pending; this output joins it
+    }
+
+    // After an idle period render on the next event loop pass to keep typing latency low
+    qint64 elapsed = sinceLastFrame.elapsed();
+    timer.start(elapsed >= frameInterval ? 0 : int(frameInterval - elapsed));
+}
+
+void RenderScheduler::onTimeout() {
+    // Still flooding: keep parsing and show only the state once the burst settles
+    if (backlog > backlogThreshold && skippedInRow < maxSkippedFrames) {
+        ++skippedInRow;
+        ++skipped;
+        backlog = 0;
+        timer.start(frameInterval);
+        return;
+    }
+
+    skippedInRow = 0;
+    backlog = 0;
+    ++rendered;
+    sinceLastFrame.restart();
+    emit frameDue();
+}
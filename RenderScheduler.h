@@ -0,0 +1,52 @@
+// RenderScheduler.h
+
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QObject> // Base class for signals and slots
+#include <QTimer> // Coalesces frame requests
+#include <QElapsedTimer> // Measures the time since the last frame
+
+/**
+ * @file RenderScheduler.h
+ * @brief Decouples PTY reads from view updates by coalescing them into display frames.
+ *
+ * Every read reports its size through requestFrame(); the scheduler emits frameDue() at
+ * most once per frame interval. When the terminal has been idle for a full frame the
+ * next frame is scheduled immediately, so an echoed keystroke is still shown without
+ * delay. While output keeps arriving faster than the backlog threshold per frame,
+ * intermediate frames are skipped (up to a bounded number in a row) so the time goes
+ * into parsing instead of drawing text nobody can read.
+ */
+class RenderScheduler : public QObject {
+    Q_OBJECT
+public:
+    explicit RenderScheduler(QObject *parent = nullptr);
+
+    void setFrameInterval(int msec) { frameInterval = msec; }
+    void setBacklogThreshold(qint64 bytes) { backlogThreshold = bytes; }
+    void setMaxSkippedFrames(int frames) { maxSkippedFrames = frames; }
+
+    void requestFrame(qint64 bytes); // New output of the given size is waiting to be shown
+
+    quint64 framesRendered() const { return rendered; }
+    quint64 framesSkipped() const { return skipped; }
+
+signals:
+    void frameDue(); // Time to push the accumulated output to the view
+
+private slots:
+    void onTimeout();
+
+private:
+    QTimer timer;
+    QElapsedTimer sinceLastFrame;
+    int frameInterval; // Milliseconds between frames
+    qint64 backlogThreshold; // Bytes per frame above which frames are skipped
+    int maxSkippedFrames; // Upper bound on consecutive skipped frames
+    qint64 backlog; // Bytes received since the last timer tick
+    int skippedInRow;
+    quint64 rendered, skipped;
+};
+
+#endif // RENDERSCHEDULER_H
@@ -0,0 +1,251 @@
+// Scrollback.cpp
+#include "Scrollback.h"
+
+#include <algorithm> // std::upper_bound
+#include <cstring> // memchr
+#include <zlib.h> // Page compression
+#include "ScrollbackPool.h" // Shared page buffers and memory budget
+
+Scrollback::Scrollback(size_t maxLines, size_t maxBytes, ScrollbackPool *pool) : pool(pool), droppedLines(0), totalLines(0), storedBytes(0), lineLimit(maxLines), byteLimit(maxBytes), inflatedFirstLine(0), inflatedValid(false) {
+    if (pool) {
+        pool->attach();
+    }
+}
+
+Scrollback::~Scrollback() {
+    clear();
+    if (pool) {
+        pool->detach();
+    }
+}
+
+void Scrollback::addStorage(size_t bytes) {
+    storedBytes += bytes;
+    if (pool) {
+        pool->charge(bytes);
+    }
+}
+
+void Scrollback::removeStorage(size_t bytes) {
+    storedBytes -= bytes;
+    if (pool) {
+        pool->discharge(bytes);
+    }
+}
+
+void Scrollback::releasePage(Page &page) {
+    if (pool && !page.compressed) {
+        pool->releasePage(page.data, page.ends);
+    }
+}
+
+void Scrollback::setLimits(size_t maxLines, size_t maxBytes) {
+    lineLimit = maxLines;
+    byteLimit = maxBytes;
+    enforceLimits();
+}
+
+void Scrollback::clear() {
+    for (Page &page : pages) {
+        releasePage(page);
+    }
+    pages.clear();
+    droppedLines += totalLines;
+    totalLines = 0;
+    removeStorage(storedBytes);
+    inflatedValid = false;
+}
+
+size_t Scrollback::pageStorage(const Page &page) const {
+    return page.data.capacity() + page.ends.capacity() * sizeof(uint32_t) + sizeof(Page);
+}
+
+size_t Scrollback::compressedPages() const {
+    size_t count = 0;
+    for (const Page &page : pages) {
+        count += page.compressed ? 1 : 0;
+    }
+    return count;
+}
+
+void Scrollback::appendCells(const Cell *cells, int count) {
+    thread_local std::string encoded; // Reused so steady-state appends do not allocate
+    encoded.clear();
+    encodeCells(cells, count, encoded);
+    appendLine(encoded.data(), encoded.size());
+}
+
+void Scrollback::encodeCells(const Cell *cells, int count, std::string &utf8) {
+    while (count > 0 && cells[count - 1].codepoint == ' ') {
+        --count;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (cells[i].attrs & Cell::WideTail) {
+            continue;
+        }
+        uint32_t cp = cells[i].codepoint;
+        if (cp < 0x80) {
+            utf8.push_back(char(cp));
+        } else if (cp < 0x800) {
+            utf8.push_back(char(0xC0 | (cp >> 6)));
+            utf8.push_back(char(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            utf8.push_back(char(0xE0 | (cp >> 12)));
+            utf8.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+            utf8.push_back(char(0x80 | (cp & 0x3F)));
+        } else {
+            utf8.push_back(char(0xF0 | (cp >> 18)));
+            utf8.push_back(char(0x80 | ((cp >> 12) & 0x3F)));
+            utf8.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+            utf8.push_back(char(0x80 | (cp & 0x3F)));
+        }
+    }
+}
+
+void Scrollback::appendLine(const char *utf8, size_t len) {
+    if (pages.empty() || pages.back().rawSize >= PageSize) {
+        // Seal the current page and deflate the one that just left the hot set
+        if (pages.size() >= HotPages) {
+            Page &cold = pages[pages.size() - HotPages];
+            if (!cold.compressed) {
+                removeStorage(pageStorage(cold));
+                compressPage(cold);
+                addStorage(pageStorage(cold));
+            }
+        }
+        Page page;
+        page.firstLine = droppedLines + totalLines;
+        if (pool) {
+            pool->takePage(page.data, page.ends);
+        } else {
+            page.data.reserve(PageSize + 256);
+            page.ends.reserve(1024);
+        }
+        pages.push_back(std::move(page));
+        addStorage(pageStorage(pages.back()));
+    }
+
+    Page &page = pages.back();
+    size_t before = pageStorage(page);
+    page.data.append(utf8, len);
+    page.data.push_back('\n');
+    page.ends.push_back(uint32_t(page.data.size()));
+    page.rawSize = uint32_t(page.data.size());
+    ++page.lines;
+    ++totalLines;
+    addStorage(pageStorage(page) - before);
+
+    enforceLimits();
+}
+
+void Scrollback::compressPage(Page &page) {
+    thread_local std::string packed; // Reused, so the exact-size copy kept is the only allocation
+    uLongf bound = compressBound(uLong(page.data.size()));
+    if (packed.size() < bound) {
+        packed.resize(bound);
+    }
+    // Level 1 favours speed: history is written far more often than it is read
+    if (compress2(reinterpret_cast<Bytef *>(&packed[0]), &bound, reinterpret_cast<const Bytef *>(page.data.data()), uLong(page.data.size()), 1) != Z_OK) {
+        return; // Keep the page uncompressed
+    }
+    std::string plain;
+    plain.swap(page.data);
+    page.data.assign(packed.data(), bound);
+    // The line index is rebuilt from the '\n' separators on inflate
+    if (pool) {
+        pool->releasePage(plain, page.ends);
+    } else {
+        std::vector<uint32_t>().swap(page.ends);
+    }
+    page.compressed = true;
+}
+
+void Scrollback::enforceLimits() {
+    // Release whole pages from the front; the newest page is never dropped
+    while (pages.size() > 1 && (totalLines > lineLimit || storedBytes > byteLimit || (pool && pool->overBudget(storedBytes)))) {
+        Page &oldest = pages.front();
+        if (inflatedValid && inflatedFirstLine == oldest.firstLine) {
+            inflatedValid = false;
+        }
+        removeStorage(pageStorage(oldest));
+        releasePage(oldest);
+        totalLines -= oldest.lines;
+        droppedLines += oldest.lines;
+        pages.pop_front();
+    }
+}
+
+void Scrollback::inflatePage(const Page &page, std::string &data, std::vector<uint32_t> &ends) {
+    data.resize(page.rawSize);
+    uLongf size = page.rawSize;
+    if (uncompress(reinterpret_cast<Bytef *>(&data[0]), &size, reinterpret_cast<const Bytef *>(page.data.data()), uLong(page.data.size())) != Z_OK) {
+        size = 0;
+    }
+    data.resize(size);
+    ends.clear();
+    const char *text = data.data();
+    for (const char *p = text; (p = static_cast<const char *>(memchr(p, '\n', size - size_t(p - text)))); ++p) {
+        ends.push_back(uint32_t(p - text) + 1);
+    }
+    ends.resize(page.lines, uint32_t(size)); // Corrupt pages read as empty lines
+}
+
+const Scrollback::Page &Scrollback::plainPage(size_t pageIndex) const {
+    const Page &page = pages[pageIndex];
+    if (!page.compressed) {
+        return page;
+    }
+    if (inflatedValid && inflatedFirstLine == page.firstLine) {
+        return inflated;
+    }
+
+    inflatePage(page, inflated.data, inflated.ends);
+    inflated.firstLine = page.firstLine;
+    inflated.lines = page.lines;
+    inflatedFirstLine = page.firstLine;
+    inflatedValid = true;
+    return inflated;
+}
+
+size_t Scrollback::pageIndexOf(uint64_t absolute) const {
+    // Last page whose first line is <= absolute
+    auto it = std::upper_bound(pages.begin(), pages.end(), absolute, [](uint64_t value, const Page &page) { return value < page.firstLine; });
+    return size_t(it - pages.begin()) - 1;
+}
+
+bool Scrollback::pageText(uint64_t lineNumber, PageText &text, PageBuffer &buffer) const {
+    if (lineNumber < droppedLines || lineNumber >= droppedLines + totalLines) {
+        return false;
+    }
+    const Page &page = pages[pageIndexOf(lineNumber)];
+    if (!page.compressed) {
+        text.data = page.data.data();
+        text.ends = page.ends.data();
+    } else if (inflatedValid && inflatedFirstLine == page.firstLine) {
+        text.data = inflated.data.data(); // Already inflated for the view
+        text.ends = inflated.ends.data();
+    } else {
+        inflatePage(page, buffer.data, buffer.ends);
+        text.data = buffer.data.data();
+        text.ends = buffer.ends.data();
+    }
+    size_t local = size_t(lineNumber - page.firstLine);
+    text.begin = local == 0 ? 0 : text.ends[local - 1];
+    text.end = text.ends[page.lines - 1];
+    text.firstLine = page.firstLine;
+    text.lines = page.lines;
+    return true;
+}
+
+std::string Scrollback::line(size_t index) const {
+    if (index >= totalLines) {
+        return std::string();
+    }
+    uint64_t absolute = droppedLines + index;
+
+    const Page &page = plainPage(pageIndexOf(absolute));
+    size_t local = size_t(absolute - page.firstLine);
+    uint32_t begin = local == 0 ? 0 : page.ends[local - 1];
+    uint32_t end = page.ends[local] - 1; // Without the '\n'
+    return page.data.substr(begin, end > begin ? end - begin : 0);
+}
@@ -0,0 +1,113 @@
+// Scrollback.h
+
+#ifndef SCROLLBACK_H
+#define SCROLLBACK_H
+
+#include <cstddef> // size_t
+#include <cstdint> // Line numbers
+#include <deque> // Ring of pages
+#include <string> // Page storage
+#include <vector> // Line offsets
+#include "TerminalScreen.h" // Cell, for lines scrolled off the screen
+
+class ScrollbackPool;
+
+/**
+ * @file Scrollback.h
+ * @brief Bounded history of lines that scrolled off the top of the screen.
+ *
+ * Lines are stored as UTF-8 text (attributes are dropped) in fixed-size pages that
+ * form a ring: once the line or byte cap is exceeded the oldest page is released.
+ * Only the newest few pages are kept as plain text; older pages are deflated, and a
+ * page is inflated again lazily when the view scrolls back into it. A compressed page
+ * keeps no per-line index, so cold history costs little more than its compressed size.
+ * Scrollbacks attached to a ScrollbackPool recycle page buffers through it and also
+ * give up pages when the sessions together exceed the pool's budget.
+ *
+ * Besides the 0-based index used by line(), every line has an absolute number that is
+ * never reused: firstLineNumber() is the absolute number of line(0). pageText() hands
+ * out whole pages of raw text for ScrollbackSearch, inflating cold pages into a buffer
+ * of the caller's, so a search sweeping the history does not evict the page the view
+ * is showing from the cache line() reads through.
+ */
+class Scrollback {
+public:
+    // Plain text of one page, from the requested line to the end of the page
+    struct PageText {
+        const char *data; // Start of the page; lines are separated by '\n'
+        size_t begin, end; // Byte range holding the requested lines
+        uint64_t firstLine; // Absolute number of the page's first line
+        const uint32_t *ends; // End offset of each of the page's lines, '\n' included
+        uint32_t lines;
+    };
+
+    // Caller's space for inflating compressed pages, see pageText()
+    struct PageBuffer {
+        std::string data;
+        std::vector<uint32_t> ends;
+    };
+
+    static constexpr size_t PageSize = 64 * 1024; // Uncompressed text per page
+    static constexpr size_t HotPages = 2; // Newest pages kept uncompressed
+
+    static constexpr size_t DefaultMaxLines = 1000000;
+    static constexpr size_t DefaultMaxBytes = 64 * 1024 * 1024;
+
+    explicit Scrollback(size_t maxLines = DefaultMaxLines, size_t maxBytes = DefaultMaxBytes, ScrollbackPool *pool = nullptr);
+    ~Scrollback();
+    Scrollback(const Scrollback &) = delete;
+    Scrollback &operator=(const Scrollback &) = delete;
+
+    void appendLine(const char *utf8, size_t len); // The line must not contain '\n'
+    void appendCells(const Cell *cells, int count); // Encodes a screen row, trailing blanks trimmed
+    static void encodeCells(const Cell *cells, int count, std::string &utf8); // The encoding appendCells() stores
+    void clear();
+
+    size_t lineCount() const { return totalLines; }
+    std::string line(size_t index) const; // 0 is the oldest retained line
+
+    uint64_t firstLineNumber() const { return droppedLines; } // Absolute number of line(0)
+    uint64_t endLineNumber() const { return droppedLines + totalLines; } // One past the newest line
+    // False if the line is not retained; valid until the next change or use of buffer
+    bool pageText(uint64_t lineNumber, PageText &text, PageBuffer &buffer) const;
+
+    size_t memoryUsage() const { return storedBytes; } // Bytes held by pages, compressed or not
+    size_t compressedPages() const;
+    size_t pageCount() const { return pages.size(); }
+
+    void setLimits(size_t maxLines, size_t maxBytes);
+
+private:
+    struct Page {
+        uint64_t firstLine = 0; // Absolute number of the page's first line
+        uint32_t lines = 0;
+        uint32_t rawSize = 0; // Size of the uncompressed text
+        bool compressed = false;
+        std::string data; // '\n' separated lines, or their deflated form
+        std::vector<uint32_t> ends; // End offset of each line; empty while compressed
+    };
+
+    void compressPage(Page &page);
+    static void inflatePage(const Page &page, std::string &data, std::vector<uint32_t> &ends); // Text and line index of a compressed page
+    const Page &plainPage(size_t pageIndex) const; // The page itself or its inflated copy
+    size_t pageIndexOf(uint64_t absolute) const; // Page holding a retained line
+    size_t pageStorage(const Page &page) const;
+    void enforceLimits();
+    void addStorage(size_t bytes);
+    void removeStorage(size_t bytes);
+    void releasePage(Page &page); // Returns a plain page's buffers to the pool
+
+    ScrollbackPool *pool;
+    std::deque<Page> pages;
+    uint64_t droppedLines; // Lines released with old pages
+    size_t totalLines;
+    size_t storedBytes;
+    size_t lineLimit, byteLimit;
+
+    // Most recently inflated page, so scrolling through a cold page decompresses it once
+    mutable Page inflated;
+    mutable uint64_t inflatedFirstLine;
+    mutable bool inflatedValid;
+};
+
+#endif // SCROLLBACK_H
@@ -0,0 +1,35 @@
+// ScrollbackPool.cpp
+#include "ScrollbackPool.h"
+
+#include "Scrollback.h" // Page size
+
+ScrollbackPool::ScrollbackPool(size_t maxBytes, size_t maxSpare) : byteLimit(maxBytes), spareLimit(maxSpare), usedBytes(0), users(0) {}
+
+void ScrollbackPool::takePage(std::string &data, std::vector<uint32_t> &ends) {
+    if (!spareData.empty()) {
+        data.swap(spareData.back());
+        ends.swap(spareEnds.back());
+        spareData.pop_back();
+        spareEnds.pop_back();
+    } else {
+        data.reserve(Scrollback::PageSize + 256);
+        ends.reserve(1024);
+    }
+}
+
+void ScrollbackPool::releasePage(std::string &data, std::vector<uint32_t> &ends) {
+    if (spareData.size() < spareLimit && data.capacity() >= Scrollback::PageSize) {
+        data.clear();
+        ends.clear();
+        spareData.push_back(std::move(data));
+        spareEnds.push_back(std::move(ends));
+    }
+    std::string().swap(data);
+    std::vector<uint32_t>().swap(ends);
+}
+
+bool ScrollbackPool::overBudget(size_t ownBytes) const {
+    // Only sessions above an even split pay, so a quiet tab keeps its history while a
+    // runaway build in another tab churns through its own
+    return usedBytes > byteLimit && users > 0 && ownBytes >= byteLimit / users;
+}
@@ -0,0 +1,49 @@
+// ScrollbackPool.h
+
+#ifndef SCROLLBACKPOOL_H
+#define SCROLLBACKPOOL_H
+
+#include <cstddef> // size_t
+#include <cstdint> // Line offsets
+#include <string> // Page text buffers
+#include <vector> // Spare buffers
+
+/**
+ * @file ScrollbackPool.h
+ * @brief Page buffers and a memory budget shared by the scrollbacks of all sessions.
+ *
+ * Every session appends to its own Scrollback, but the uncompressed page buffers are
+ * drawn from and returned to this pool, so a busy session reuses the buffers a page
+ * compression just freed instead of going back to the allocator. The pool also sums
+ * the storage of all attached scrollbacks: once the total exceeds the shared budget,
+ * scrollbacks holding more than their even share release their oldest pages.
+ * GUI thread only, like the scrollbacks themselves.
+ */
+class ScrollbackPool {
+public:
+    explicit ScrollbackPool(size_t maxBytes = 256 * 1024 * 1024, size_t maxSpare = 32);
+
+    // Buffers for a new page, recycled when possible
+    void takePage(std::string &data, std::vector<uint32_t> &ends);
+    // Hands a page's buffers back; they are cleared, and freed if enough are spare already
+    void releasePage(std::string &data, std::vector<uint32_t> &ends);
+
+    void attach() { ++users; }
+    void detach() { --users; }
+    void charge(size_t bytes) { usedBytes += bytes; }
+    void discharge(size_t bytes) { usedBytes -= bytes; }
+    bool overBudget(size_t ownBytes) const; // Should a scrollback holding ownBytes give pages back?
+
+    size_t memoryUsage() const { return usedBytes; } // Bytes held by all attached scrollbacks
+    size_t spareBuffers() const { return spareData.size(); }
+    size_t budget() const { return byteLimit; }
+
+private:
+    std::vector<std::string> spareData;
+    std::vector<std::vector<uint32_t>> spareEnds;
+    size_t byteLimit, spareLimit;
+    size_t usedBytes;
+    size_t users;
+};
+
+#endif // SCROLLBACKPOOL_H
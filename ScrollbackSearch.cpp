@@ -0,0 +1,125 @@
+// ScrollbackSearch.cpp
+#include "ScrollbackSearch.h"
+
+#include <algorithm> // std::upper_bound
+#include "TextSearch.h" // Vectorised substring search
+
+ScrollbackSearch::ScrollbackSearch(const Scrollback *history) : history(history), nextLine(0), scanned(0) {}
+
+bool ScrollbackSearch::setPattern(const std::string &newPattern, bool regex) {
+    clear();
+    if (newPattern.empty() || newPattern.find('\n') != std::string::npos) {
+        return newPattern.empty();
+    }
+    if (regex) {
+        try {
+            expression.reset(new std::regex(newPattern, std::regex::ECMAScript | std::regex::optimize));
+        } catch (const std::regex_error &) {
+            return false;
+        }
+        literal = TextSearch::requiredLiteral(newPattern);
+    } else {
+        literal = newPattern;
+    }
+    pattern = newPattern;
+    nextLine = history->firstLineNumber();
+    return true;
+}
+
+void ScrollbackSearch::clear() {
+    pattern.clear();
+    literal.clear();
+    expression.reset();
+    found.clear();
+    scanned = 0;
+}
+
+size_t ScrollbackSearch::step(size_t byteBudget) {
+    if (!active()) {
+        return 0;
+    }
+
+    // Forget what the history has let go of since the last step
+    const uint64_t first = history->firstLineNumber();
+    while (!found.empty() && found.front().line < first) {
+        found.pop_front();
+    }
+    nextLine = std::max(nextLine, first);
+
+    // Whole pages at a time: a compressed page is inflated once per scan
+    size_t bytes = 0;
+    Scrollback::PageText text;
+    while (bytes < byteBudget && history->pageText(nextLine, text, pageBuffer)) {
+        if (expression) {
+            scanRegex(text);
+        } else {
+            scanLiteral(text);
+        }
+        bytes += text.end - text.begin;
+        nextLine = text.firstLine + text.lines;
+    }
+    scanned += bytes;
+    return bytes;
+}
+
+bool ScrollbackSearch::caughtUp() const {
+    return !active() || nextLine >= history->endLineNumber();
+}
+
+uint32_t ScrollbackSearch::lineAt(const Scrollback::PageText &text, size_t offset) const {
+    return uint32_t(std::upper_bound(text.ends, text.ends + text.lines, uint32_t(offset)) - text.ends);
+}
+
+void ScrollbackSearch::addMatch(uint64_t line, size_t offset, size_t length) {
+    if (found.size() == MaxMatches) {
+        found.pop_front();
+    }
+    found.push_back(Match{line, uint32_t(offset), uint32_t(length)});
+}
+
+void ScrollbackSearch::scanLiteral(const Scrollback::PageText &text) {
+    // The literal has no '\n', so a hit never crosses into the next line
+    size_t pos = text.begin;
+    while (pos < text.end) {
+        const char *hit = TextSearch::find(text.data + pos, text.end - pos, literal.data(), literal.size());
+        if (!hit) {
+            break;
+        }
+        size_t offset = size_t(hit - text.data);
+        uint32_t line = lineAt(text, offset);
+        size_t lineStart = line == 0 ? 0 : text.ends[line - 1];
+        addMatch(text.firstLine + line, offset - lineStart, literal.size());
+        pos = offset + literal.size();
+    }
+}
+
+void ScrollbackSearch::scanRegex(const Scrollback::PageText &text) {
+    uint32_t line = lineAt(text, text.begin);
+    if (literal.empty()) {
+        for (; line < text.lines; ++line) {
+            scanLine(text, line);
+        }
+        return;
+    }
+
+    // Only lines holding the required literal can match
+    size_t pos = text.begin;
+    while (pos < text.end) {
+        const char *hit = TextSearch::find(text.data + pos, text.end - pos, literal.data(), literal.size());
+        if (!hit) {
+            break;
+        }
+        line = lineAt(text, size_t(hit - text.data));
+        scanLine(text, line);
+        pos = text.ends[line];
+    }
+}
+
+void ScrollbackSearch::scanLine(const Scrollback::PageText &text, uint32_t line) {
+    const char *begin = text.data + (line == 0 ? 0 : text.ends[line - 1]);
+    const char *end = text.data + text.ends[line] - 1; // Without the '\n'
+    const std::cregex_iterator last;
+    for (std::cregex_iterator it(begin, end, *expression, std::regex_constants::match_not_null); it != last; ++it) {
+        addMatch(text.firstLine + line, size_t(it->position()), size_t(it->length()));
+    }
+}
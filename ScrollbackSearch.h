@@ -0,0 +1,67 @@
+// ScrollbackSearch.h
+
+#ifndef SCROLLBACKSEARCH_H
+#define SCROLLBACKSEARCH_H
+
+#include <cstddef> // size_t
+#include <cstdint> // Line numbers
+#include <deque> // Matches, pruned from the front as history is released
+#include <memory> // The compiled regex
+#include <regex> // Regex searches
+#include <string>
+#include "Scrollback.h" // The history being searched
+
+/**
+ * @file ScrollbackSearch.h
+ * @brief Incremental literal or regex search over a Scrollback.
+ *
+ * The search scans the history's raw UTF-8 pages with TextSearch::find() and never
+ * builds a document or converts text to UTF-16. step() scans up to a byte budget and
+ * returns, so the caller can spread a search over many event loop iterations and show
+ * matches as they come in. The scan position is an absolute line number: once the
+ * search has caught up, lines appended later are scanned by the next step(), and
+ * matches in lines the history has released are dropped. A regex is only run on lines
+ * that contain its required literal (TextSearch::requiredLiteral()), if it has one.
+ * Matches are byte ranges within a line and never span lines. Past MaxMatches the
+ * oldest are let go, as the newest output is usually what is being looked for.
+ */
+class ScrollbackSearch {
+public:
+    struct Match {
+        uint64_t line; // Absolute line number, see Scrollback::firstLineNumber()
+        uint32_t offset; // Bytes into the line
+        uint32_t length; // Bytes
+    };
+
+    static constexpr size_t MaxMatches = 1000000;
+
+    explicit ScrollbackSearch(const Scrollback *history);
+
+    bool setPattern(const std::string &pattern, bool regex); // Restarts; false if the pattern is invalid or spans lines
+    void clear(); // No pattern, no matches
+    bool active() const { return !pattern.empty(); }
+
+    size_t step(size_t byteBudget); // Scans whole pages until the budget is used up; returns the bytes scanned
+    bool caughtUp() const; // Every retained line has been scanned
+
+    const std::deque<Match> &matches() const { return found; } // Oldest first
+    uint64_t bytesScanned() const { return scanned; }
+
+private:
+    void scanLiteral(const Scrollback::PageText &text);
+    void scanRegex(const Scrollback::PageText &text);
+    void scanLine(const Scrollback::PageText &text, uint32_t line); // Runs the regex on one line of the page
+    uint32_t lineAt(const Scrollback::PageText &text, size_t offset) const; // Page line holding a byte
+    void addMatch(uint64_t line, size_t offset, size_t length);
+
+    const Scrollback *history;
+    std::string pattern;
+    std::string literal; // Searched with TextSearch; for a regex, its required literal
+    std::unique_ptr<std::regex> expression; // Null for literal searches
+    uint64_t nextLine; // Absolute number of the first line not yet scanned
+    std::deque<Match> found;
+    uint64_t scanned;
+    Scrollback::PageBuffer pageBuffer; // Cold pages are inflated here, not in the view's cache
+};
+
+#endif // SCROLLBACKSEARCH_H
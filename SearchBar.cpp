@@ -0,0 +1,135 @@
+// SearchBar.cpp
+#include "SearchBar.h"
+
+#include <QHBoxLayout> //Lays out the field, the switch and the count.
+#include <QKeyEvent> //Enter and Escape in the field.
+#include <algorithm> //std::lower_bound
+
+// Orders matches the way ScrollbackSearch finds them
+static bool before(const ScrollbackSearch::Match &a, const ScrollbackSearch::Match &b) {
+    return a.line != b.line ? a.line < b.line : a.offset < b.offset;
+}
+
+SearchBar::SearchBar(const Scrollback *history, QWidget *parent) : QWidget(parent), search(history), field(nullptr), regexBox(nullptr), status(nullptr), hasSelection(false), selected() {
+    field = new QLineEdit(this);
+    field->setPlaceholderText(tr("Search history"));
+    field->installEventFilter(this);
+    regexBox = new QCheckBox(tr("Regex"), this);
+    status = new QLabel(this);
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(field, 1);
+    layout->addWidget(regexBox);
+    layout->addWidget(status);
+    setLayout(layout);
+
+    connect(field, &QLineEdit::textChanged, this, &SearchBar::restart);
+    connect(regexBox, &QCheckBox::toggled, this, &SearchBar::restart);
+
+    // A zero interval runs one slice per pass of the event loop while there is text left
+    scanTimer.setInterval(0);
+    connect(&scanTimer, &QTimer::timeout, this, &SearchBar::scan);
+    hide();
+}
+
+void SearchBar::open() {
+    show();
+    field->setFocus();
+    field->selectAll();
+    restart();
+}
+
+void SearchBar::historyChanged() {
+    if (search.active() && !scanTimer.isActive()) {
+        scanTimer.start();
+    }
+}
+
+void SearchBar::restart() {
+    scanTimer.stop();
+    hasSelection = false;
+    if (!search.setPattern(field->text().toStdString(), regexBox->isChecked())) {
+        status->setText(tr("Invalid pattern"));
+        return;
+    }
+    scan(); // The first slice right away, so short histories need no extra pass
+}
+
+void SearchBar::scan() {
+    search.step(SliceBytes);
+    if (search.caughtUp()) {
+        scanTimer.stop();
+    } else if (!scanTimer.isActive()) {
+        scanTimer.start();
+    }
+    updateStatus();
+}
+
+void SearchBar::dismiss() {
+    scanTimer.stop();
+    search.clear();
+    hasSelection = false;
+    hide();
+    emit closed();
+}
+
+size_t SearchBar::selectedIndex() const {
+    const std::deque<ScrollbackSearch::Match> &matches = search.matches();
+    auto it = std::lower_bound(matches.begin(), matches.end(), selected, before);
+    return it != matches.end() && !before(selected, *it) ? size_t(it - matches.begin()) : matches.size();
+}
+
+void SearchBar::select(bool older) {
+    const std::deque<ScrollbackSearch::Match> &matches = search.matches();
+    if (matches.empty()) {
+        return;
+    }
+    const size_t count = matches.size();
+    size_t index = count - 1; // Without a selection both directions start at the newest
+    if (hasSelection) {
+        // The selection may have been released with old history; move from where it was
+        size_t next = size_t(std::lower_bound(matches.begin(), matches.end(), selected, before) - matches.begin());
+        if (older) {
+            index = next == 0 ? count - 1 : next - 1;
+        } else {
+            if (next < count && !before(selected, matches[next])) {
+                ++next;
+            }
+            index = next == count ? 0 : next;
+        }
+    }
+    selected = matches[index];
+    hasSelection = true;
+    emit matchSelected(selected.line, int(selected.offset), int(selected.length));
+    updateStatus();
+}
+
+void SearchBar::updateStatus() {
+    if (!search.active()) {
+        status->clear();
+        return;
+    }
+    const size_t count = search.matches().size();
+    const size_t index = hasSelection ? selectedIndex() : count;
+    QString text = index < count ? tr("%1 of %2").arg(index + 1).arg(count) : tr("%1 matches").arg(count);
+    if (!search.caughtUp()) {
+        text += tr(", searching...");
+    }
+    status->setText(text);
+}
+
+bool SearchBar::eventFilter(QObject *obj, QEvent *event) {
+    if (obj == field && event->type() == QEvent::KeyPress) {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+        if (keyEvent->key() == Qt::Key_Return || keyEvent->key() == Qt::Key_Enter) {
+            select(!(keyEvent->modifiers() & Qt::ShiftModifier));
+            return true;
+        }
+        if (keyEvent->key() == Qt::Key_Escape) {
+            dismiss();
+            return true;
+        }
+    }
+    return QWidget::eventFilter(obj, event);
+}
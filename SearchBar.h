@@ -0,0 +1,59 @@
+// SearchBar.h
+
+#ifndef SEARCHBAR_H
+#define SEARCHBAR_H
+
+#include <QWidget> // Base class for the bar
+#include <QLineEdit> // Pattern field
+#include <QCheckBox> // Regex switch
+#include <QLabel> // Match count
+#include <QTimer> // Spreads the scan over event loop iterations
+#include "ScrollbackSearch.h" // The search itself
+
+/**
+ * @file SearchBar.h
+ * @brief Find bar for a session's scrollback.
+ *
+ * The search restarts as the pattern is typed and runs in slices of a few MiB between
+ * other events, so the count grows while a large history is being scanned and the
+ * terminal stays responsive. Output that scrolls into the history later is searched
+ * as it arrives (historyChanged()). Enter selects the next older match, Shift+Enter
+ * the next newer one, and Escape closes the bar.
+ */
+class SearchBar : public QWidget {
+    Q_OBJECT
+public:
+    explicit SearchBar(const Scrollback *history, QWidget *parent = nullptr);
+
+    void open(); // Shows the bar and focuses the pattern field
+    void historyChanged(); // Lines were added to the history; scans them if searching
+
+signals:
+    void matchSelected(quint64 line, int offset, int length); // Absolute line number, byte range in the line
+    void closed();
+
+protected:
+    bool eventFilter(QObject *obj, QEvent *event) override; // Enter, Shift+Enter and Escape in the field
+
+private slots:
+    void restart(); // The pattern or the mode changed
+    void scan(); // One slice of the search
+    void dismiss();
+
+private:
+    static constexpr size_t SliceBytes = 4 * 1024 * 1024; // Text scanned per event loop iteration
+
+    void select(bool older);
+    size_t selectedIndex() const; // Position of the selected match, or matches().size() if gone
+    void updateStatus();
+
+    ScrollbackSearch search;
+    QLineEdit *field;
+    QCheckBox *regexBox;
+    QLabel *status;
+    QTimer scanTimer;
+    bool hasSelection;
+    ScrollbackSearch::Match selected;
+};
+
+#endif // SEARCHBAR_H
@@ -0,0 +1,76 @@
+// SessionManager.cpp
+#include "SessionManager.h"
+
+#include <QShortcut> //New and close tab keys.
+#include <cstdio> //Statistics on exit.
+
+SessionManager::SessionManager(QWidget *parent) : QTabWidget(parent), reactor(nullptr), overlay(nullptr) {
+    reactor = new PtyReactor(this);
+    reactor->start();
+    atlas = TerminalView::createGlyphAtlas();
+
+    setDocumentMode(true);
+    setTabsClosable(true);
+    setMovable(true);
+    connect(this, &QTabWidget::tabCloseRequested, this, &SessionManager::closeSession);
+    connect(this, &QTabWidget::currentChanged, this, &SessionManager::updateWindowTitle);
+
+    // Application wide shortcuts win over the view, which would send the keys to the shell
+    QShortcut *newTab = new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_T), this);
+    newTab->setContext(Qt::WindowShortcut);
+    connect(newTab, &QShortcut::activated, this, &SessionManager::openSession);
+    QShortcut *closeTab = new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_W), this);
+    closeTab->setContext(Qt::WindowShortcut);
+    connect(closeTab, &QShortcut::activated, this, [this]() { closeSession(currentIndex()); });
+
+    if (Instrumentation::compiledIn) {
+        overlay = new StatsOverlay(this);
+        QShortcut *stats = new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_I), this);
+        stats->setContext(Qt::WindowShortcut);
+        connect(stats, &QShortcut::activated, overlay, &StatsOverlay::toggle);
+    }
+}
+
+SessionManager::~SessionManager() {
+    // Sessions go first, including closed ones still waiting for deleteLater(): they hand
+    // their channels back to the reactor and use the atlas and the pool
+    qDeleteAll(findChildren<TerminalEmulator *>());
+    reactor->stop();
+    if (qEnvironmentVariableIsSet("TERME_READ_STATS")) {
+        fprintf(stderr, "%s\n", qPrintable(reactor->readStatistics().summary()));
+    }
+}
+
+TerminalEmulator *SessionManager::openSession() {
+    SessionResources resources = {reactor, atlas.get(), &pool};
+    TerminalEmulator *session = new TerminalEmulator(resources);
+    int index = addTab(session, tr("Shell"));
+    connect(session, &TerminalEmulator::finished, this, &SessionManager::sessionFinished);
+    connect(session, &QWidget::windowTitleChanged, this, [this, session](const QString &title) {
+        setTabText(indexOf(session), title);
+        updateWindowTitle();
+    });
+    setCurrentIndex(index);
+    return session;
+}
+
+void SessionManager::closeSession(int index) {
+    QWidget *session = widget(index);
+    if (!session) {
+        return;
+    }
+    removeTab(index);
+    session->deleteLater(); // May be called from one of the session's own signals
+    if (count() == 0) {
+        close();
+    }
+}
+
+void SessionManager::sessionFinished() {
+    closeSession(indexOf(qobject_cast<QWidget *>(sender())));
+}
+
+void SessionManager::updateWindowTitle() {
+    QString title = tabText(currentIndex());
+    setWindowTitle(title.isEmpty() || title == tr("Shell") ? tr("Qt Terminal Emulator") : title);
+}
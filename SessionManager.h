@@ -0,0 +1,49 @@
+// SessionManager.h
+
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <QTabWidget> // One tab per session
+#include <memory>
+#include "GlyphAtlas.h" // Glyph cache shared by all sessions
+#include "PtyReactor.h" // I/O thread shared by all sessions
+#include "ScrollbackPool.h" // History pages shared by all sessions
+#include "TerminalEmulator.h" // The sessions
+#include "StatsOverlay.h" // Live instrumentation numbers
+
+/**
+ * @file SessionManager.h
+ * @brief Window hosting any number of shell sessions as tabs.
+ *
+ * All sessions share one PtyReactor thread, one GlyphAtlas and one ScrollbackPool, so
+ * an extra session costs its PTY, its screen and its widgets but no thread, glyph cache
+ * or separate history budget. Only the current tab renders; the others keep parsing
+ * output in the reactor and catch up when they are shown.
+ * Ctrl+Shift+T opens a session and Ctrl+Shift+W closes the current one; a session whose
+ * shell exits closes its tab, and closing the last tab closes the window. In builds with
+ * instrumentation, Ctrl+Shift+I toggles a StatsOverlay over the tabs.
+ */
+class SessionManager : public QTabWidget {
+    Q_OBJECT
+public:
+    explicit SessionManager(QWidget *parent = nullptr);
+    ~SessionManager() override;
+
+    TerminalEmulator *openSession(); // Starts a shell in a new tab and makes it current
+    void closeSession(int index);
+
+    const PtyReactor &ioReactor() const { return *reactor; }
+    const ScrollbackPool &scrollbackPool() const { return pool; }
+
+private slots:
+    void sessionFinished();
+    void updateWindowTitle();
+
+private:
+    PtyReactor *reactor;
+    std::unique_ptr<GlyphAtlas> atlas;
+    ScrollbackPool pool; // Declared before the sessions are created, destroyed after them
+    StatsOverlay *overlay; // Only created when instrumentation is built in
+};
+
+#endif // SESSIONMANAGER_H
@@ -0,0 +1,116 @@
+// ShellLauncher.cpp
+#include "ShellLauncher.h"
+
+#include <spawn.h> //posix_spawn and its file actions.
+#include <fcntl.h> //Open flags for the PTY pair.
+#include <unistd.h> //close().
+#include <stdlib.h> //posix_openpt, grantpt, unlockpt, ptsname_r.
+#include <signal.h> //Signal dispositions for the child.
+#include <termios.h> //Line discipline settings.
+#include <sys/ioctl.h> //Initial window size.
+#include <pwd.h> //Fallback login shell.
+#include <cerrno> //Preserves the error across cleanup.
+#include <cstring> //strncmp.
+#include <vector>
+
+extern char **environ;
+
+std::string ShellLauncher::shellPath() {
+    const char *shell = getenv("SHELL");
+    if (shell && *shell) {
+        return shell;
+    }
+    struct passwd *entry = getpwuid(getuid());
+    if (entry && entry->pw_shell && *entry->pw_shell) {
+        return entry->pw_shell;
+    }
+    return "/bin/sh";
+}
+
+bool ShellLauncher::launch(int columns, int rows, Process &process) {
+    int masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (masterFd == -1) {
+        return false;
+    }
+    char slaveName[128];
+    if (grantpt(masterFd) == -1 || unlockpt(masterFd) == -1 || ptsname_r(masterFd, slaveName, sizeof(slaveName)) != 0) {
+        int error = errno;
+        ::close(masterFd);
+        errno = error;
+        return false;
+    }
+
+    // Held open until the shell has its own descriptors, so the PTY is fully set up
+    // before the shell starts and never sees a hangup in between
+    int slaveFd = ::open(slaveName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slaveFd == -1) {
+        int error = errno;
+        ::close(masterFd);
+        errno = error;
+        return false;
+    }
+    struct winsize size = {};
+    size.ws_col = static_cast<unsigned short>(columns);
+    size.ws_row = static_cast<unsigned short>(rows);
+    ioctl(slaveFd, TIOCSWINSZ, &size);
+    struct termios settings;
+    if (tcgetattr(slaveFd, &settings) == 0) {
+        settings.c_iflag |= IUTF8; // Line editing erases whole UTF-8 characters
+        tcsetattr(slaveFd, TCSANOW, &settings);
+    }
+
+    // The environment of the GUI with the terminal type replaced
+    std::vector<std::string> variables;
+    for (char **entry = environ; *entry; ++entry) {
+        if (strncmp(*entry, "TERM=", 5) != 0 && strncmp(*entry, "COLORTERM=", 10) != 0) {
+            variables.push_back(*entry);
+        }
+    }
+    variables.push_back("TERM=xterm-256color"); // Enables 256-colour support
+    variables.push_back("COLORTERM=truecolor"); // SGR 38;2 and 48;2 are supported as well
+    std::vector<char *> envp;
+    for (std::string &variable : variables) {
+        envp.push_back(&variable[0]);
+    }
+    envp.push_back(nullptr);
+
+    std::string shell = shellPath();
+    char *argv[] = {&shell[0], nullptr};
+
+    // New session, then stdin opened by name: a session leader opening a terminal
+    // without O_NOCTTY makes it its controlling terminal, as TIOCSCTTY did
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, slaveName, O_RDWR, 0);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDERR_FILENO);
+
+    // Signals the GUI blocks or ignores must not leak into the shell
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigfillset(&signals);
+    sigdelset(&signals, SIGKILL);
+    sigdelset(&signals, SIGSTOP);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    pid_t pid = -1;
+    int error = posix_spawnp(&pid, shell.c_str(), &actions, &attributes, argv, envp.data());
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    ::close(slaveFd);
+    if (error != 0) {
+        ::close(masterFd);
+        errno = error;
+        return false;
+    }
+
+    // Reads are drained until EAGAIN, so the master must not block
+    fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+    process.masterFd = masterFd;
+    process.pid = pid;
+    return true;
+}
@@ -0,0 +1,34 @@
+// ShellLauncher.h
+
+#ifndef SHELLLAUNCHER_H
+#define SHELLLAUNCHER_H
+
+#include <sys/types.h> // pid_t
+#include <string>
+
+/**
+ * @file ShellLauncher.h
+ * @brief Starts the user's shell on a fresh pseudo-terminal with posix_spawn().
+ *
+ * fork() from the GUI process has to copy the page tables of everything Qt has mapped,
+ * only for the child to throw them away in exec(). posix_spawn() (clone with CLONE_VFORK
+ * in glibc) runs the child on the parent's memory until exec, so the cost no longer
+ * grows with the size of the emulator. Everything the child used to do by hand is set
+ * up beforehand: the slave is opened, sized and configured in the parent, the new
+ * session is created by the spawn attributes, and the child reopens the slave by name
+ * as its controlling terminal. The environment is built explicitly.
+ */
+class ShellLauncher {
+public:
+    struct Process {
+        int masterFd = -1; // Non-blocking and close-on-exec
+        pid_t pid = -1;
+    };
+
+    // Starts the shell on a new PTY of the given size; returns false with errno set on failure
+    static bool launch(int columns, int rows, Process &process);
+
+    static std::string shellPath(); // $SHELL, the passwd entry's shell, or /bin/sh
+};
+
+#endif // SHELLLAUNCHER_H
@@ -0,0 +1,80 @@
+// SpscQueue.h
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic> // Lock-free head/tail indices
+#include <cstddef> // size_t
+#include <memory> // Slot storage
+#include <utility> // std::move
+
+/**
+ * @file SpscQueue.h
+ * @brief Bounded lock-free queue for exactly one producer and one consumer thread.
+ *
+ * Used to hand work between the PTY I/O thread and the GUI thread without a mutex.
+ * The producer only writes tail and the consumer only writes head; each side keeps a
+ * cached copy of the other's index so the shared cache lines are touched only when the
+ * queue looks full or empty.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : mask(roundUp(capacity) - 1), buffer(new T[mask + 1]) {}
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side; fails instead of blocking when the queue is full
+    bool tryPush(T &&value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead > mask) {
+                return false;
+            }
+        }
+        buffer[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; fails when the queue is empty
+    bool tryPop(T &value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) {
+                return false;
+            }
+        }
+        value = std::move(buffer[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a third thread; exact from either end for its own side
+    size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+    bool isEmpty() const { return size() == 0; }
+    size_t capacity() const { return mask + 1; }
+
+private:
+    static size_t roundUp(size_t value) {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t mask;
+    std::unique_ptr<T[]> buffer;
+
+    // Producer and consumer indices on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cachedTail = 0; // Consumer's copy of tail
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t cachedHead = 0; // Producer's copy of head
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,43 @@
+// StartupTrace.h
+
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer> // Monotonic clock since launch
+#include <QtGlobal> // qEnvironmentVariableIsSet
+#include <cstdio> // Reports go to stderr
+
+/**
+ * @file StartupTrace.h
+ * @brief Startup timing reports, enabled by setting TERME_STARTUP_TIMING.
+ *
+ * main() starts the clock before anything else; sessions then report when their widgets
+ * are ready, when the shell was spawned, when its first output (normally the prompt)
+ * arrived and when that output was first painted, both relative to the session's own
+ * creation and to the launch of the process. Opening a tab later measures new-tab
+ * latency the same way.
+ */
+class StartupTrace {
+public:
+    static bool enabled() {
+        static const bool on = qEnvironmentVariableIsSet("TERME_STARTUP_TIMING");
+        return on;
+    }
+
+    static void processStarted() { clock().start(); }
+
+    // Reports an event that happened sessionMs after the reporting session was created
+    static void report(const char *event, double sessionMs) {
+        if (enabled()) {
+            fprintf(stderr, "startup: %-14s %8.2f ms into the session, %8.2f ms since launch\n", event, sessionMs, clock().isValid() ? double(clock().nsecsElapsed()) / 1e6 : 0.0);
+        }
+    }
+
+private:
+    static QElapsedTimer &clock() {
+        static QElapsedTimer timer;
+        return timer;
+    }
+};
+
+#endif // STARTUPTRACE_H
@@ -0,0 +1,109 @@
+// StatsOverlay.cpp
+#include "StatsOverlay.h"
+
+#include <QPainter> //Draws the panel.
+#include <QFontMetrics> //Sizes the panel to its text.
+#include <QEvent> //Parent resize notifications.
+
+static QString formatBytes(double bytes) {
+    if (bytes >= 1024.0 * 1024.0) {
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MiB";
+    }
+    if (bytes >= 1024.0) {
+        return QString::number(bytes / 1024.0, 'f', 1) + " KiB";
+    }
+    return QString::number(bytes, 'f', 0) + " B";
+}
+
+StatsOverlay::StatsOverlay(QWidget *parent) : QWidget(parent), previous(capture()) {
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    QFont mono("Monospace");
+    mono.setStyleHint(QFont::TypeWriter);
+    setFont(mono);
+    parent->installEventFilter(this);
+
+    timer.setInterval(500);
+    connect(&timer, &QTimer::timeout, this, &StatsOverlay::sample);
+    hide();
+}
+
+void StatsOverlay::toggle() {
+    if (isVisible()) {
+        timer.stop();
+        hide();
+        return;
+    }
+    previous = capture();
+    sinceSample.start();
+    lines = QStringList() << tr("collecting...");
+    place();
+    show();
+    raise();
+    timer.start();
+}
+
+StatsOverlay::Snapshot StatsOverlay::capture() {
+    Snapshot snapshot;
+    for (int i = 0; i < Instrumentation::CounterCount; ++i) {
+        snapshot.counters[i] = Instrumentation::value(Instrumentation::Counter(i));
+    }
+    for (int i = 0; i < Instrumentation::PhaseCount; ++i) {
+        snapshot.phases[i] = Instrumentation::totals(Instrumentation::Phase(i));
+    }
+    return snapshot;
+}
+
+void StatsOverlay::sample() {
+    Snapshot now = capture();
+    double seconds = qMax(1e-3, sinceSample.restart() / 1000.0);
+    auto rate = [&](Instrumentation::Counter counter) { return double(now.counters[counter] - previous.counters[counter]) / seconds; };
+
+    const Instrumentation::PhaseTotals &render = now.phases[Instrumentation::Render];
+    const Instrumentation::PhaseTotals &renderBefore = previous.phases[Instrumentation::Render];
+    uint64_t frames = render.count - renderBefore.count;
+    double frameMs = frames ? double(render.nanoseconds - renderBefore.nanoseconds) / 1e6 / double(frames) : 0.0;
+
+    lines.clear();
+    lines << QString("fps %1   frame %2 ms").arg(rate(Instrumentation::FramesPainted), 0, 'f', 1).arg(frameMs, 0, 'f', 2);
+    lines << QString("pty in %1/s   out %2/s").arg(formatBytes(rate(Instrumentation::BytesRead)), formatBytes(rate(Instrumentation::BytesWritten)));
+    lines << QString("queue input %1   write %2").arg(formatBytes(double(now.counters[Instrumentation::InputBacklog])), formatBytes(double(now.counters[Instrumentation::PendingWrite])));
+    QString busy = "busy ms/s";
+    for (int i = 0; i < Instrumentation::PhaseCount; ++i) {
+        double ms = double(now.phases[i].nanoseconds - previous.phases[i].nanoseconds) / 1e6 / seconds;
+        busy += QString("  %1 %2").arg(Instrumentation::phaseName(Instrumentation::Phase(i))).arg(ms, 0, 'f', 1);
+    }
+    lines << busy;
+    previous = now;
+
+    place();
+    update();
+}
+
+void StatsOverlay::place() {
+    QFontMetrics metrics(font());
+    int width = 0;
+    for (const QString &line : lines) {
+        width = qMax(width, metrics.horizontalAdvance(line));
+    }
+    QSize size(width + 16, metrics.height() * int(lines.size()) + 12);
+    setGeometry(parentWidget()->width() - size.width() - 8, 8, size.width(), size.height());
+}
+
+bool StatsOverlay::eventFilter(QObject *obj, QEvent *event) {
+    if (obj == parentWidget() && event->type() == QEvent::Resize && isVisible()) {
+        place();
+    }
+    return QWidget::eventFilter(obj, event);
+}
+
+void StatsOverlay::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(0, 0, 0, 190));
+    painter.setPen(QColor(0x7f, 0xff, 0x7f));
+    QFontMetrics metrics(font());
+    int y = 6 + metrics.ascent();
+    for (const QString &line : lines) {
+        painter.drawText(8, y, line);
+        y += metrics.height();
+    }
+}
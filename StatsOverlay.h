@@ -0,0 +1,50 @@
+// StatsOverlay.h
+
+#ifndef STATSOVERLAY_H
+#define STATSOVERLAY_H
+
+#include <QWidget> // Base class for the overlay
+#include <QTimer> // Periodic refresh
+#include <QElapsedTimer> // Interval between samples
+#include <QStringList> // Lines shown
+#include "Instrumentation.h" // The numbers being shown
+
+/**
+ * @file StatsOverlay.h
+ * @brief Translucent panel in the corner of its parent with live instrumentation numbers.
+ *
+ * Twice a second the counters and phase timers of Instrumentation are sampled and the
+ * rates since the previous sample are shown: frames per second and average frame time,
+ * PTY bytes per second in both directions, the input and write queue depths, and how
+ * many milliseconds per second each phase kept its thread busy.
+ */
+class StatsOverlay : public QWidget {
+    Q_OBJECT
+public:
+    explicit StatsOverlay(QWidget *parent);
+
+    void toggle(); // Shows or hides the overlay, sampling afresh when shown
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    bool eventFilter(QObject *obj, QEvent *event) override; // Follows the parent's size
+
+private slots:
+    void sample();
+
+private:
+    struct Snapshot {
+        int64_t counters[Instrumentation::CounterCount];
+        Instrumentation::PhaseTotals phases[Instrumentation::PhaseCount];
+    };
+
+    static Snapshot capture();
+    void place();
+
+    QTimer timer;
+    QElapsedTimer sinceSample;
+    Snapshot previous;
+    QStringList lines;
+};
+
+#endif // STATSOVERLAY_H
@@ -3,156 +3,196 @@
 
 #include <QVBoxLayout> //Provides vertical layout management.
 #include <QApplication> //The base class for Qt GUI applications.
-#include <QTimer>
-#include <QSocketNotifier> //Monitors file descriptors for I/O operations.
-#include <QRegularExpression> //Used for pattern matching
-#include <pty.h> //Manages pseudo-terminal devices.
-#include <unistd.h> //Provides system-level I/O operations.
-#include <termios.h> //Configures terminal attributes.
-#include <sys/ioctl.h> //Handles signals like SIGINT.
-#include <signal.h> //Manages terminal I/O control.
-#include <poll.h> // Handles polling file descriptors.
-#include <iostream> //For C++ standard input and output.
-#include <cstdlib> //Provides general utilities like exit.
+#include <QTimer> //Deferred shell start and reaping.
+#include <QShortcut> //Opens the search bar.
+#include "ShellLauncher.h" //Spawns the shell on a new PTY.
+#include "StartupTrace.h" //Optional startup timing.
+#include "Instrumentation.h" //Apply timer.
+#include <signal.h> //Sends signals to the shell.
+#include <sys/wait.h> //Reaps the shell.
+#include <cerrno> //Reason a spawn failed.
+#include <cstring> //strerror.
 
 
 // Definition of TerminalEmulator Constructor
-TerminalEmulator::TerminalEmulator(QWidget *parent) : QWidget(parent), outputArea(nullptr), inputArea(nullptr), master_fd(-1), slave_fd(-1), readNotifier(nullptr),childPid(-1) {
+TerminalEmulator::TerminalEmulator(const SessionResources &resources, QWidget *parent) : QWidget(parent), outputArea(nullptr), inputArea(nullptr), searchBar(nullptr), master_fd(-1), reactor(resources.reactor), channel(nullptr), inputWriter(nullptr), renderScheduler(nullptr), childPid(-1), firstOutputSeen(false), firstFramePainted(false), scrollback(Scrollback::DefaultMaxLines, Scrollback::DefaultMaxBytes, resources.scrollbackPool) {
+    startupClock.start();
+
      // Setup the UI with a vertical box layout containing an output area and input area
-    outputArea = new QPlainTextEdit(this); //we pass this which is the parent of outputArea
+    outputArea = new TerminalView(&screen, this); //we pass this which is the parent of outputArea
+    outputArea->setScrollback(&scrollback);
+    outputArea->setGlyphAtlas(resources.atlas);
     inputArea = new QLineEdit(this);
     inputArea->setFocus(); // Will shift the focus to the input area when the Application opens
-    outputArea->setReadOnly(true); // Sets the Output Area to readonly mode
+    searchBar = new SearchBar(&scrollback, this);
 
     QVBoxLayout *layout = new QVBoxLayout(this); // Creates an instance of QVBoxLayout which contains the input and output area
     layout->addWidget(outputArea);
+    layout->addWidget(searchBar);
     layout->addWidget(inputArea);
 
     setLayout(layout); // Sets The Application layout in a vertical manner
     inputArea->installEventFilter(this); //Installs an event filter on the `inputArea` to capture and handle specific events.
 
 
-    // Setup pseudo-terminal
-    if (openpty(&master_fd, &slave_fd, nullptr, nullptr, nullptr) == -1) {
-        perror("openpty");
-        exit(1);
-    }
+    // Output is collected between frames and pushed to the view at most once per frame
+    renderScheduler = new RenderScheduler(this);
+    connect(renderScheduler, &RenderScheduler::frameDue, this, &TerminalEmulator::flushOutput);
 
-    // Fork the child process - Creates a duplicate process
-    pid_t pid = fork();
-    if (pid == -1) {
-        perror("fork");
-        exit(1);
-    }
+    // Input typed before the shell is up waits in the writer
+    inputWriter = new InputWriter(nullptr, this);
 
-    if (pid == 0) { // Child process
-        ::close(master_fd); // Close master in child process
+    // Handle user input
+    connect(inputArea, &QLineEdit::returnPressed, this, &TerminalEmulator::sendInput);
+    connect(outputArea, &TerminalView::keyInput, this, &TerminalEmulator::writeToMaster);
+    connect(outputArea, &TerminalView::pasteRequested, this, &TerminalEmulator::paste);
 
-        setsid(); // Create a new session to detach the child process from the terminal
+    // Keep the screen and the shell's idea of the window size in sync with the view
+    connect(outputArea, &TerminalView::gridResized, this, &TerminalEmulator::resizeTerminal);
 
-        if (ioctl(slave_fd, TIOCSCTTY, 0) == -1) { // Making the Slave side the controlling terminal
-            perror("ioctl");
-            exit(1);
-        }
-        dup2(slave_fd, STDIN_FILENO); // Redirect standard input to the slave PTY
-        dup2(slave_fd, STDOUT_FILENO); // Redirect standard output to the slave PTY
-        dup2(slave_fd, STDERR_FILENO); // Redirect standard error to the slave PTY
-        ::close(slave_fd); // Close slave after duplication
-
-        // Set the TERM environment variable to 'xterm-256color' to enable 256-color support
-        if (setenv("TERM", "xterm-256color", 1) == -1) {
-            perror("setenv");
-            exit(1);
-        }
-        // Retrieve the user's default shell from the SHELL environment variable
-        const char *shell = getenv("SHELL");
-        if (!shell) {
-            perror("getenv");
-            exit(1);
-        }
-        const char *logMessage = "Slave terminal started successfully.\n";
-        write(STDOUT_FILENO, logMessage, strlen(logMessage));
-        execlp(shell, shell, nullptr); // Execute the retrieved shell
-        perror("execlp");
-        exit(1);
-    } else { // Parent process
-        childPid = pid; // Store the child process ID for later use
-        ::close(slave_fd); // Close slave in parent process
-
-        // Monitor master_fd for output
-        readNotifier = new QSocketNotifier(master_fd, QSocketNotifier::Read, this);
-        connect(readNotifier, &QSocketNotifier::activated, this, &TerminalEmulator::readFromMaster);
-
-        // Handle user input
-        connect(inputArea, &QLineEdit::returnPressed, this, &TerminalEmulator::sendInput);
+    // Scrollback search; the shortcut takes precedence over the view sending keys to the shell
+    QShortcut *find = new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_F), this);
+    find->setContext(Qt::WidgetWithChildrenShortcut);
+    connect(find, &QShortcut::activated, searchBar, &SearchBar::open);
+    connect(searchBar, &SearchBar::matchSelected, outputArea, &TerminalView::showMatch);
+    connect(searchBar, &SearchBar::closed, this, [this]() {
+        outputArea->clearMatch();
+        outputArea->setFocus();
+    });
+
+    // The shell is started from the event loop, so the window is shown first and opening
+    // a tab never waits for the spawn
+    QTimer::singleShot(0, this, &TerminalEmulator::startShell);
+    StartupTrace::report("widgets ready", startupClock.nsecsElapsed() / 1e6);
+}
 
+void TerminalEmulator::startShell() {
+    ShellLauncher::Process process;
+    if (!ShellLauncher::launch(screen.columns(), screen.rows(), process)) {
+        // Keep the tab open with the reason instead of taking every other session down
+        std::string reason = strerror(errno);
+        std::string message = "\033[31mCannot start " + ShellLauncher::shellPath() + ": " + reason + "\033[0m\r\n";
+        AnsiParser parser(&screen);
+        parser.feed(message.data(), message.size());
+        flushOutput();
+        return;
     }
+    master_fd = process.masterFd;
+    childPid = process.pid;
+    StartupTrace::report("shell spawned", startupClock.nsecsElapsed() / 1e6);
+
+    // The reactor owns master_fd from here on: it reads, parses and writes, and hands
+    // screen updates over without ever waiting for the GUI
+    channel = reactor->open(master_fd, screen.columns(), screen.rows());
+    connect(channel, &PtyChannel::updatesAvailable, this, &TerminalEmulator::takeUpdates, Qt::QueuedConnection);
+    inputWriter->setChannel(channel);
+}
 
+// Reaps a killed shell so closed tabs leave no zombies behind, without blocking the GUI
+// on a child that takes a moment to die: until it has exited, it is checked again from
+// the event loop. Children left at exit are inherited and reaped by init
+static void reap(pid_t pid) {
+    pid_t result;
+    do {
+        result = waitpid(pid, nullptr, WNOHANG);
+    } while (result == -1 && errno == EINTR);
+    if (result == 0 && QCoreApplication::instance()) {
+        QTimer::singleShot(100, QCoreApplication::instance(), [pid]() { reap(pid); });
+    }
 }
 
 TerminalEmulator::~TerminalEmulator() {
-    ::close(master_fd); // Explicitly close the master file descriptor
+    if (channel) {
+        reactor->close(channel); // The reactor closes master_fd once it has let go of it
+    }
     if (childPid > 0) {
         kill(childPid, SIGKILL); // Kill child process if it is still running
+        reap(childPid);
     }
 }
 
-void TerminalEmulator::readFromMaster() {
-    // Buffer to hold data read from the master PTY
-    char buffer[256];
-
-    // Read data from the master PTY into the buffer
-    ssize_t count = read(master_fd, buffer, sizeof(buffer) - 1);
+void TerminalEmulator::takeUpdates() {
+    TERME_SCOPE(Apply);
+    // Clear the flag first: an update published while draining sends a fresh signal
+    channel->acknowledgeUpdates();
+
+    bool eof = false, historyGrew = false;
+    qint64 bytes = 0;
+    while (channel->takeUpdate(screenUpdate)) {
+        screen.applyUpdate(screenUpdate);
+        size_t begin = 0;
+        for (size_t end : screenUpdate.historyEnds) {
+            scrollback.appendLine(screenUpdate.history.data() + begin, end - begin);
+            begin = end;
+        }
+        historyGrew = historyGrew || !screenUpdate.historyEnds.empty();
+        bytes += qint64(screenUpdate.bytes);
+        eof = eof || screenUpdate.eof;
+    }
+    if (historyGrew) {
+        searchBar->historyChanged(); // An open search also covers the new lines
+    }
 
-    if (count > 0) {
-        buffer[count] = '\0'; // Null-terminate the buffer to make it a valid C-string
+    if (screen.titleChanged()) {
+        setWindowTitle(QString::fromStdString(screen.title())); // Also names a background tab
+    }
+    if (bytes > 0 && !firstOutputSeen) {
+        firstOutputSeen = true;
+        StartupTrace::report("first prompt", startupClock.nsecsElapsed() / 1e6);
+    }
 
-        // Convert the buffer to a QString
-        QString output = QString::fromLocal8Bit(buffer);
+    if (eof) {
+        flushOutput(); // Show the last output without waiting for a frame
+        emit finished();
+    } else if (bytes > 0 && isVisible()) {
+        renderScheduler->requestFrame(bytes); // Shown with the next display frame
+    }
+}
 
-        // Handle ANSI escape sequences for clearing the terminal screen
-        if (output.contains("\033[H\033[2J")) {
-            outputArea->clear(); // Clear the terminal output
-            output.remove(QRegularExpression("\033\\[H\\033\\[2J")); // Remove the sequence
-        }
+void TerminalEmulator::flushOutput() {
+    if (!isVisible()) {
+        return; // Damage keeps accumulating in the screen until the session is shown
+    }
 
-        // Remove ANSI escape sequences for styling and control characters
-        output.remove(QRegularExpression("\x1B\\[[0-9;]*[a-zA-Z]")); // CSI sequences
-        output.remove(QRegularExpression("\x1B\\][^\\x07]*\\x07"));  // OSC sequences
-        output.remove(QRegularExpression("\x1B\\[\\?2004[h|l]"));    // Bracketed paste mode sequences
-        output.remove(QRegularExpression("\x1B\\(B"));               // Character set sequence
-        output.remove(QRegularExpression("\x1B\\]0;[^\\x07]*\\x07"));// Title setting sequences
-        output.remove(QRegularExpression("[\x00-\x1F\x7F]"));           // Remove other non-printable control characters
-
-        // Append the cleaned output to the output area for display
-        outputArea->appendPlainText(output);
-    } else if (count == 0) { // EOF
-        readNotifier->setEnabled(false); // Disable the read notifier on EOF
-    } else { // Error
-        perror("read"); // Print an error message if reading fails
+    // Repaint just the rows changed since the last frame
+    outputArea->updateDamage();
+    if (firstOutputSeen && !firstFramePainted) {
+        firstFramePainted = true;
+        StartupTrace::report("prompt shown", startupClock.nsecsElapsed() / 1e6);
     }
 }
 
+void TerminalEmulator::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    flushOutput();
+}
 
+void TerminalEmulator::writeToMaster(const QByteArray &data) {
+    inputWriter->write(data);
+}
+
+void TerminalEmulator::paste(const QString &text) {
+    // The mode comes from the last update; a program switching it while the paste is
+    // in flight only sees the markers it asked for at the time
+    inputWriter->paste(text, screen.bracketedPasteEnabled());
+}
+
+void TerminalEmulator::resizeTerminal(int columns, int rows) {
+    // The local copy is resized right away so painting matches the widget; the I/O
+    // thread resizes its screen and the PTY and then sends the redrawn rows
+    screen.resize(columns, rows);
+    if (channel) {
+        channel->postResize(columns, rows);
+    }
+    outputArea->updateDamage();
+}
 
 void TerminalEmulator::sendInput() {
     // Retrieve the user input from the input area, append a newline character
     QString input = inputArea->text() + "\n";
 
-    // Debugging output to display the input being sent
-    qDebug() << "Sending input to master_fd:" << input;
-
-    // Write the input to the master PTY
-    ssize_t bytesWritten = write(master_fd, input.toLocal8Bit().constData(), input.size());
-
-    // Check if the write operation was successful
-    if (bytesWritten == -1) {
-        // Error handling: Print an error message if the write operation failed
-        perror("write failed");
-    } else {
-        // Debugging output: Show the number of bytes written to the master PTY
-        qDebug() << "Bytes written:" << bytesWritten;
-    }
+    // Hand the input to the I/O thread, which writes it to the master PTY
+    writeToMaster(input.toUtf8());
 
     // Clear the input area after sending the input
     inputArea->clear();
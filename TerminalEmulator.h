@@ -4,9 +4,23 @@
 #define TERMINALEMULATOR_H
 
 #include <QWidget> // Base class for the UI elements
-#include <QPlainTextEdit> //multi-line text display. Used here to show terminal output.
 #include <QLineEdit> //single-line text input. Used for capturing user input.
-#include <QSocketNotifier> //Monitors file descriptors for events
+#include <QElapsedTimer> // Startup timing
+#include "TerminalScreen.h" // Cell grid the parsed output is applied to
+#include "TerminalView.h" // Draws the screen, repainting only damaged rows
+#include "Scrollback.h" // Bounded history of lines scrolled off the screen
+#include "PtyReactor.h" // Reads, parses and writes the PTYs off the GUI thread
+#include "ScrollbackPool.h" // Page buffers shared by all sessions' history
+#include "InputWriter.h" // Queues input for the shell without blocking the GUI
+#include "RenderScheduler.h" // Limits view updates to the display frame rate
+#include "SearchBar.h" // Finds text in the scrollback
+
+// Resources shared by all sessions of a window; owned by SessionManager
+struct SessionResources {
+    PtyReactor *reactor; // Serves every session's PTY
+    GlyphAtlas *atlas; // Glyph cache for all views
+    ScrollbackPool *scrollbackPool; // Page buffers and memory budget for all histories
+};
 
 /**
  * @file TerminalEmulator.h
@@ -14,29 +28,50 @@
  *
  * This class uses a pseudo-terminal (PTY) to interact with a shell process and provides a
  * graphical interface for terminal input and output. It supports reading and writing data
- * to the shell, handling Ctrl+C, and managing ANSI escape sequences.
+ * to the shell, handling Ctrl+C, and managing ANSI escape sequences. Each instance is
+ * one session; the reactor thread, glyph cache and scrollback pages are shared with the
+ * other sessions through SessionResources. A hidden session keeps applying updates but
+ * does no rendering work until it is shown again. Ctrl+Shift+F searches the scrollback.
  */
 class TerminalEmulator : public QWidget {
     Q_OBJECT // a macro for signal slot mechanism
 public:
-    explicit TerminalEmulator(QWidget *parent = nullptr); // Constructor to set up UI and PTY
+    explicit TerminalEmulator(const SessionResources &resources, QWidget *parent = nullptr); // Constructor to set up UI and PTY
     ~TerminalEmulator() override; // Destructor to clean up resources
 
+signals:
+    void finished(); // The shell exited and its last output has been shown
+
 protected:
     bool eventFilter(QObject *obj, QEvent *event) override; // Filter specific events, e.g., Ctrl+C
+    void showEvent(QShowEvent *event) override; // Catches up on output received while hidden
 
 private slots:
-    void readFromMaster(); // Reads shell output from the master PTY
+    void startShell(); // Spawns the shell once the widgets are up
+    void takeUpdates(); // Applies the screen updates published by the I/O thread
     void sendInput(); // Sends user input to the shell
+    void flushOutput(); // Pushes the screen changes since the last frame to the view
+    void writeToMaster(const QByteArray &data); // Queues raw bytes for the shell, e.g. keys typed into the view
+    void paste(const QString &text); // Sends pasted text, bracketed if the shell asked for it
+    void resizeTerminal(int columns, int rows); // Resizes the screen and the PTY window size
 
 private:
     void handleCtrlC(); // Handles Ctrl+C to send SIGINT to the shell process
 
-    QPlainTextEdit *outputArea; // Displays terminal output
+    TerminalView *outputArea; // Displays terminal output
     QLineEdit *inputArea; // Captures user input
-    int master_fd, slave_fd; // File descriptors for the PTY
-    QSocketNotifier *readNotifier; // Monitors the PTY for readable data
+    SearchBar *searchBar; // Hidden until Ctrl+Shift+F
+    int master_fd; // Master side of the shell's PTY
+    PtyReactor *reactor; // Shared I/O thread serving this session's PTY
+    PtyChannel *channel; // Owns master_fd once the shell is running
+    InputWriter *inputWriter; // Holds input back while the shell is not reading
+    RenderScheduler *renderScheduler; // Decides when collected output is shown
     pid_t childPid; // Process ID of the child shell process
+    QElapsedTimer startupClock; // Runs from construction, for StartupTrace
+    bool firstOutputSeen, firstFramePainted;
+    TerminalScreen screen; // GUI thread copy of the screen, updated from the I/O thread
+    Scrollback scrollback; // Lines that scrolled off the top of the screen
+    ScreenUpdate screenUpdate; // Receives updates popped from the I/O thread's queue
 };
 
 #endif // TERMINALEMULATOR_H
@@ -0,0 +1,764 @@
+// TerminalScreen.cpp
+#include "TerminalScreen.h"
+
+#include <algorithm> // std::min, std::max, std::fill, std::copy, std::rotate
+#include <numeric> // std::iota for the row tables
+
+// Display width of a codepoint: 0 for combining marks, 2 for East Asian wide characters
+int TerminalScreen::charWidth(uint32_t cp) {
+    if (cp < 0x300) {
+        return 1;
+    }
+    if ((cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x200B && cp <= 0x200F) || (cp >= 0xFE00 && cp <= 0xFE0F)) {
+        return 0;
+    }
+    if ((cp >= 0x1100 && cp <= 0x115F) || (cp >= 0x2E80 && cp <= 0x303E) || (cp >= 0x3041 && cp <= 0x33FF) ||
+        (cp >= 0x3400 && cp <= 0x4DBF) || (cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0xA000 && cp <= 0xA4CF) ||
+        (cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0xF900 && cp <= 0xFAFF) || (cp >= 0xFE30 && cp <= 0xFE4F) ||
+        (cp >= 0xFF00 && cp <= 0xFF60) || (cp >= 0xFFE0 && cp <= 0xFFE6) || (cp >= 0x1F300 && cp <= 0x1F64F) ||
+        (cp >= 0x1F900 && cp <= 0x1F9FF) || (cp >= 0x20000 && cp <= 0x3FFFD)) {
+        return 2;
+    }
+    return 1;
+}
+
+TerminalScreen::TerminalScreen(int columns, int rows) : cols(std::max(1, columns)), numRows(std::max(1, rows)), damaged(true), cursorCol(0), cursorRow(0), wrapPending(false), scrollTop(0), scrollBottom(numRows - 1), autoWrap(true), showCursor(true), altActive(false), bracketedPaste(false), originMode(false), titleDirty(false) {
+    cells.assign(size_t(cols) * numRows, Cell());
+    altCells.assign(size_t(cols) * numRows, Cell());
+    rowMap.resize(size_t(numRows));
+    std::iota(rowMap.begin(), rowMap.end(), 0);
+    altRowMap = rowMap;
+    dirty.assign(size_t(numRows), 1);
+}
+
+void TerminalScreen::resize(int columns, int rows) {
+    columns = std::max(1, columns);
+    rows = std::max(1, rows);
+    if (columns == cols && rows == numRows) {
+        return;
+    }
+
+    // When shrinking, rows below the cursor are dropped first, like xterm; only if the
+    // cursor would still be off the bottom do rows leave at the top. Each buffer goes by
+    // its own cursor: while the alternate screen shows, the primary's is the saved one
+    const int shift = std::max(0, cursorRow - (rows - 1));
+    const int primaryShift = altActive ? std::max(0, saved.row - (rows - 1)) : shift;
+    const int altShift = altActive ? shift : 0;
+
+    // Copies the rows in screen order, so the resized buffer starts with an identity table
+    auto resizeBuffer = [&](std::vector<Cell> &buffer, std::vector<int> &map, int from) {
+        std::vector<Cell> resized(size_t(columns) * rows, Cell());
+        for (int r = 0; r < std::min(rows, numRows - from); ++r) {
+            const Cell *src = &buffer[size_t(map[size_t(r + from)]) * cols];
+            Cell *dst = &resized[size_t(r) * columns];
+            std::copy(src, src + std::min(cols, columns), dst);
+            if (dst[columns - 1].attrs & Cell::Wide) { // Its tail was cut off
+                dst[columns - 1].codepoint = ' ';
+                dst[columns - 1].attrs &= ~Cell::Wide;
+            }
+        }
+        buffer.swap(resized);
+        map.resize(size_t(rows));
+        std::iota(map.begin(), map.end(), 0);
+    };
+    std::vector<Cell> &primary = altActive ? altCells : cells;
+    std::vector<int> &primaryMap = altActive ? altRowMap : rowMap;
+    if (onLineScrolledOut) { // Primary rows leaving at the top go to the history either way
+        for (int r = 0; r < primaryShift; ++r) {
+            onLineScrolledOut(&primary[size_t(primaryMap[size_t(r)]) * cols], cols);
+        }
+    }
+    resizeBuffer(primary, primaryMap, primaryShift);
+    resizeBuffer(altActive ? cells : altCells, altActive ? rowMap : altRowMap, altShift);
+
+    cols = columns;
+    numRows = rows;
+    cursorRow = std::min(cursorRow - shift, numRows - 1);
+    cursorCol = std::min(cursorCol, cols - 1);
+    saved.row = std::min(std::max(0, saved.row - primaryShift), numRows - 1); // Same text under it after DECRC
+    wrapPending = false;
+    scrollTop = 0;
+    scrollBottom = numRows - 1;
+    dirty.assign(size_t(numRows), 0);
+    markAllDirty();
+}
+
+void TerminalScreen::clearDamage() {
+    std::fill(dirty.begin(), dirty.end(), 0);
+    damaged = false;
+}
+
+void TerminalScreen::markAllDirty() {
+    std::fill(dirty.begin(), dirty.end(), 1);
+    damaged = true;
+}
+
+bool TerminalScreen::titleChanged() {
+    bool changed = titleDirty;
+    titleDirty = false;
+    return changed;
+}
+
+std::string TerminalScreen::takeResponses() {
+    std::string taken;
+    taken.swap(responses);
+    return taken;
+}
+
+void TerminalScreen::takeUpdate(ScreenUpdate &update) {
+    update.columns = cols;
+    update.rows = numRows;
+    update.rowIndexes.clear();
+    update.cells.clear();
+    if (damaged) {
+        for (int r = 0; r < numRows; ++r) {
+            if (dirty[size_t(r)]) {
+                update.rowIndexes.push_back(r);
+                update.cells.insert(update.cells.end(), row(r), row(r) + cols);
+            }
+        }
+    }
+    update.cursorX = cursorCol;
+    update.cursorY = cursorRow;
+    update.cursorVisible = showCursor;
+    update.alternateScreen = altActive;
+    update.bracketedPaste = bracketedPaste;
+    update.titleChanged = titleChanged();
+    if (update.titleChanged) {
+        update.title = windowTitle;
+    }
+    clearDamage();
+}
+
+void TerminalScreen::applyUpdate(const ScreenUpdate &update) {
+    // Rows from before a resize reached the other screen are clipped to this size
+    int width = std::min(cols, update.columns);
+    for (size_t i = 0; i < update.rowIndexes.size(); ++i) {
+        int r = update.rowIndexes[i];
+        if (r >= numRows) {
+            continue;
+        }
+        const Cell *src = &update.cells[i * size_t(update.columns)];
+        Cell *dst = rowPtr(r);
+        std::copy(src, src + width, dst);
+        std::fill(dst + width, dst + cols, Cell());
+        markDirty(r);
+    }
+    cursorCol = std::min(update.cursorX, cols - 1);
+    cursorRow = std::min(update.cursorY, numRows - 1);
+    showCursor = update.cursorVisible;
+    altActive = update.alternateScreen;
+    bracketedPaste = update.bracketedPaste;
+    if (update.titleChanged) {
+        windowTitle = update.title;
+        titleDirty = true;
+    }
+}
+
+Cell TerminalScreen::blankCell() const {
+    Cell blank;
+    blank.bg = pen.bg;
+    return blank;
+}
+
+void TerminalScreen::print(const char *data, size_t len) {
+    const char *end = data + len;
+    while (data < end) {
+        if (!utf8.pending()) {
+            size_t ascii = Utf8Decoder::asciiPrefix(data, size_t(end - data));
+            putAscii(data, ascii);
+            data += ascii;
+        }
+        data = utf8.decode(data, end, [this](uint32_t cp) { putCodepoint(cp); });
+    }
+}
+
+void TerminalScreen::interruptSequence() {
+    if (utf8.abandon()) {
+        putCodepoint(Utf8Decoder::Replacement);
+    }
+}
+
+// Turns a wide character whose other half is being overwritten, erased or moved into
+// two blanks, so no Wide cell is left without its WideTail or the other way round
+void TerminalScreen::breakWide(Cell *line, int from, int to) {
+    auto blank = [](Cell &cell) {
+        cell.codepoint = ' ';
+        cell.attrs &= ~(Cell::Wide | Cell::WideTail);
+    };
+    if (from > 0 && from < cols && (line[from].attrs & Cell::WideTail)) {
+        blank(line[from - 1]);
+        blank(line[from]);
+    }
+    if (to > 0 && to < cols && (line[to - 1].attrs & Cell::Wide)) {
+        blank(line[to - 1]);
+        blank(line[to]);
+    }
+}
+
+void TerminalScreen::putAscii(const char *text, size_t len) {
+    // Same placement as putCodepoint() for width 1, a row segment at a time
+    while (len > 0) {
+        if (wrapPending) {
+            if (autoWrap) {
+                cursorCol = 0;
+                lineFeed();
+            } else {
+                cursorCol = cols - 1;
+            }
+            wrapPending = false;
+        }
+        size_t count = std::min(len, size_t(cols - cursorCol));
+        Cell *line = rowPtr(cursorRow);
+        breakWide(line, cursorCol, cursorCol + int(count));
+        Cell *cell = line + cursorCol;
+        for (size_t i = 0; i < count; ++i) {
+            cell[i] = pen;
+            cell[i].codepoint = static_cast<unsigned char>(text[i]);
+        }
+        markDirty(cursorRow);
+        text += count;
+        len -= count;
+        cursorCol += int(count);
+        if (cursorCol >= cols) {
+            cursorCol = cols - 1;
+            wrapPending = true;
+        }
+    }
+}
+
+void TerminalScreen::putCodepoint(uint32_t cp) {
+    int width = charWidth(cp);
+    if (width == 0) {
+        return; // Combining marks are not composed onto the previous cell
+    }
+    if (width > cols) {
+        cp = Utf8Decoder::Replacement; // A wide character cannot fit a one column grid
+        width = 1;
+    }
+
+    if (wrapPending || cursorCol + width > cols) {
+        if (autoWrap) {
+            cursorCol = 0;
+            lineFeed();
+        } else {
+            cursorCol = std::max(0, cols - width);
+        }
+        wrapPending = false;
+    }
+
+    Cell *line = rowPtr(cursorRow);
+    breakWide(line, cursorCol, cursorCol + width);
+    Cell &cell = line[cursorCol];
+    cell = pen;
+    cell.codepoint = cp;
+    if (width == 2) {
+        cell.attrs |= Cell::Wide;
+        Cell &tail = line[cursorCol + 1];
+        tail = pen;
+        tail.codepoint = ' ';
+        tail.attrs |= Cell::WideTail;
+    }
+    markDirty(cursorRow);
+
+    cursorCol += width;
+    if (cursorCol >= cols) {
+        cursorCol = cols - 1;
+        wrapPending = true;
+    }
+}
+
+void TerminalScreen::execute(unsigned char control) {
+    interruptSequence();
+    switch (control) {
+    case '\n':
+    case '\v':
+    case '\f':
+        lineFeed();
+        break;
+    case '\r':
+        cursorCol = 0;
+        wrapPending = false;
+        break;
+    case '\b':
+        if (cursorCol > 0) {
+            --cursorCol;
+        }
+        wrapPending = false;
+        break;
+    case '\t':
+        cursorCol = std::min(cols - 1, (cursorCol / 8 + 1) * 8);
+        wrapPending = false;
+        break;
+    default:
+        break; // BEL, SO/SI and the rest have no visible effect
+    }
+}
+
+void TerminalScreen::lineFeed() {
+    wrapPending = false;
+    if (cursorRow == scrollBottom) {
+        scrollUp(scrollTop, scrollBottom, 1);
+    } else if (cursorRow < numRows - 1) {
+        ++cursorRow;
+    }
+}
+
+void TerminalScreen::reverseLineFeed() {
+    wrapPending = false;
+    if (cursorRow == scrollTop) {
+        scrollDown(scrollTop, scrollBottom, 1);
+    } else if (cursorRow > 0) {
+        --cursorRow;
+    }
+}
+
+void TerminalScreen::scrollUp(int top, int bottom, int count) {
+    count = std::min(count, bottom - top + 1);
+    if (count <= 0) {
+        return;
+    }
+    if (top == 0 && !altActive && onLineScrolledOut) {
+        for (int r = 0; r < count; ++r) {
+            onLineScrolledOut(rowPtr(r), cols);
+        }
+    }
+    // The rows that left the region come back blank at its bottom
+    std::rotate(rowMap.begin() + top, rowMap.begin() + top + count, rowMap.begin() + bottom + 1);
+    for (int r = bottom - count + 1; r <= bottom; ++r) {
+        eraseInRow(r, 0, cols);
+    }
+    for (int r = top; r <= bottom; ++r) {
+        markDirty(r);
+    }
+}
+
+void TerminalScreen::scrollDown(int top, int bottom, int count) {
+    count = std::min(count, bottom - top + 1);
+    if (count <= 0) {
+        return;
+    }
+    std::rotate(rowMap.begin() + top, rowMap.begin() + bottom + 1 - count, rowMap.begin() + bottom + 1);
+    for (int r = top; r < top + count; ++r) {
+        eraseInRow(r, 0, cols);
+    }
+    for (int r = top; r <= bottom; ++r) {
+        markDirty(r);
+    }
+}
+
+void TerminalScreen::eraseInRow(int index, int from, int to) {
+    from = std::max(0, from);
+    to = std::min(cols, to);
+    if (from >= to) {
+        return;
+    }
+    Cell *line = rowPtr(index);
+    breakWide(line, from, to);
+    std::fill(line + from, line + to, blankCell());
+    markDirty(index);
+}
+
+void TerminalScreen::eraseInDisplay(int mode) {
+    switch (mode) {
+    case 0: // Cursor to end of screen
+        eraseInRow(cursorRow, cursorCol, cols);
+        for (int r = cursorRow + 1; r < numRows; ++r) {
+            eraseInRow(r, 0, cols);
+        }
+        break;
+    case 1: // Start of screen to cursor
+        for (int r = 0; r < cursorRow; ++r) {
+            eraseInRow(r, 0, cols);
+        }
+        eraseInRow(cursorRow, 0, cursorCol + 1);
+        break;
+    case 2: // Whole screen (3 would also drop the scrollback)
+    case 3:
+        for (int r = 0; r < numRows; ++r) {
+            eraseInRow(r, 0, cols);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::eraseInLine(int mode) {
+    switch (mode) {
+    case 0:
+        eraseInRow(cursorRow, cursorCol, cols);
+        break;
+    case 1:
+        eraseInRow(cursorRow, 0, cursorCol + 1);
+        break;
+    case 2:
+        eraseInRow(cursorRow, 0, cols);
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::insertBlanks(int count) {
+    Cell *line = rowPtr(cursorRow);
+    count = std::min(count, cols - cursorCol);
+    breakWide(line, cursorCol, cursorCol); // Blanks go between the halves
+    breakWide(line, cols - count, cols - count); // The tail would be pushed off the row
+    std::copy_backward(line + cursorCol, line + cols - count, line + cols);
+    std::fill(line + cursorCol, line + cursorCol + count, blankCell());
+    markDirty(cursorRow);
+}
+
+void TerminalScreen::deleteChars(int count) {
+    Cell *line = rowPtr(cursorRow);
+    count = std::min(count, cols - cursorCol);
+    breakWide(line, cursorCol, cursorCol + count);
+    std::copy(line + cursorCol + count, line + cols, line + cursorCol);
+    std::fill(line + cols - count, line + cols, blankCell());
+    markDirty(cursorRow);
+}
+
+void TerminalScreen::moveCursor(int col, int row) {
+    int top = originMode ? scrollTop : 0;
+    int bottom = originMode ? scrollBottom : numRows - 1;
+    cursorCol = std::max(0, std::min(col, cols - 1));
+    cursorRow = std::max(top, std::min(row + top, bottom));
+    wrapPending = false;
+}
+
+void TerminalScreen::csiDispatch(const int *params, int paramCount, char privateMarker,
+                                 const char *intermediates, int intermediateCount, char final) {
+    interruptSequence();
+    // Parameter i, with 0 or a missing value replaced by the default
+    auto arg = [&](int i, int fallback) { return (i < paramCount && params[i] > 0) ? params[i] : fallback; };
+
+    if (privateMarker == '?') {
+        if (final == 'h' || final == 'l') {
+            for (int i = 0; i < paramCount; ++i) {
+                setMode(params[i], true, final == 'h');
+            }
+        }
+        return;
+    }
+    if (privateMarker != 0) {
+        return; // Secondary DA and similar queries are not answered
+    }
+    if (intermediateCount > 0) {
+        if (intermediates[0] == '!' && final == 'p') {
+            softReset(); // DECSTR
+        }
+        return;
+    }
+
+    switch (final) {
+    case 'A': // CUU
+        cursorRow = std::max(cursorRow >= scrollTop ? scrollTop : 0, cursorRow - arg(0, 1));
+        wrapPending = false;
+        break;
+    case 'B': // CUD
+    case 'e': // VPR
+        cursorRow = std::min(cursorRow <= scrollBottom ? scrollBottom : numRows - 1, cursorRow + arg(0, 1));
+        wrapPending = false;
+        break;
+    case 'C': // CUF
+    case 'a': // HPR
+        cursorCol = std::min(cols - 1, cursorCol + arg(0, 1));
+        wrapPending = false;
+        break;
+    case 'D': // CUB
+        cursorCol = std::max(0, cursorCol - arg(0, 1));
+        wrapPending = false;
+        break;
+    case 'E': // CNL
+        cursorRow = std::min(numRows - 1, cursorRow + arg(0, 1));
+        cursorCol = 0;
+        wrapPending = false;
+        break;
+    case 'F': // CPL
+        cursorRow = std::max(0, cursorRow - arg(0, 1));
+        cursorCol = 0;
+        wrapPending = false;
+        break;
+    case 'G': // CHA
+    case '`': // HPA
+        cursorCol = std::min(cols - 1, arg(0, 1) - 1);
+        wrapPending = false;
+        break;
+    case 'H': // CUP
+    case 'f': // HVP
+        moveCursor(arg(1, 1) - 1, arg(0, 1) - 1);
+        break;
+    case 'd': // VPA
+        moveCursor(cursorCol, arg(0, 1) - 1);
+        break;
+    case 'J': // ED
+        eraseInDisplay(paramCount > 0 ? params[0] : 0);
+        break;
+    case 'K': // EL
+        eraseInLine(paramCount > 0 ? params[0] : 0);
+        break;
+    case 'L': // IL
+        if (cursorRow >= scrollTop && cursorRow <= scrollBottom) {
+            scrollDown(cursorRow, scrollBottom, arg(0, 1));
+            cursorCol = 0;
+            wrapPending = false;
+        }
+        break;
+    case 'M': // DL
+        if (cursorRow >= scrollTop && cursorRow <= scrollBottom) {
+            // Deleted lines are not part of the history, so bypass scrollUp's callback
+            auto callback = std::move(onLineScrolledOut);
+            onLineScrolledOut = nullptr;
+            scrollUp(cursorRow, scrollBottom, arg(0, 1));
+            onLineScrolledOut = std::move(callback);
+            cursorCol = 0;
+            wrapPending = false;
+        }
+        break;
+    case '@': // ICH
+        insertBlanks(arg(0, 1));
+        break;
+    case 'P': // DCH
+        deleteChars(arg(0, 1));
+        break;
+    case 'X': // ECH
+        eraseInRow(cursorRow, cursorCol, cursorCol + arg(0, 1));
+        break;
+    case 'S': // SU
+        scrollUp(scrollTop, scrollBottom, arg(0, 1));
+        break;
+    case 'T': // SD
+        scrollDown(scrollTop, scrollBottom, arg(0, 1));
+        break;
+    case 'm': // SGR
+        selectGraphicRendition(params, paramCount);
+        break;
+    case 'r': { // DECSTBM
+        int top = arg(0, 1) - 1;
+        int bottom = arg(1, numRows) - 1;
+        if (top < bottom && bottom < numRows) {
+            scrollTop = top;
+            scrollBottom = bottom;
+            moveCursor(0, 0);
+        }
+        break;
+    }
+    case 'h':
+    case 'l':
+        for (int i = 0; i < paramCount; ++i) {
+            setMode(params[i], false, final == 'h');
+        }
+        break;
+    case 's': // SCOSC
+        saveCursor();
+        break;
+    case 'u': // SCORC
+        restoreCursor();
+        break;
+    case 'n': // DSR
+        if (arg(0, 0) == 5) {
+            responses += "\033[0n";
+        } else if (arg(0, 0) == 6) {
+            int row = originMode ? cursorRow - scrollTop : cursorRow;
+            responses += "\033[" + std::to_string(row + 1) + ";" + std::to_string(cursorCol + 1) + "R";
+        }
+        break;
+    case 'c': // DA: identify as a VT220 with ANSI colour
+        if (arg(0, 0) == 0) {
+            responses += "\033[?62;22c";
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::setMode(int mode, bool privateMode, bool enable) {
+    if (!privateMode) {
+        return; // Insert mode (4) and friends are not supported
+    }
+    switch (mode) {
+    case 6: // DECOM
+        originMode = enable;
+        moveCursor(0, 0);
+        break;
+    case 7: // DECAWM
+        autoWrap = enable;
+        break;
+    case 25: // DECTCEM
+        showCursor = enable;
+        markDirty(cursorRow);
+        break;
+    case 47:
+    case 1047:
+        switchScreen(enable);
+        break;
+    case 1049: // Alternate screen with saved cursor
+        if (enable) {
+            saveCursor();
+            switchScreen(true);
+            eraseInDisplay(2);
+        } else {
+            switchScreen(false);
+            restoreCursor();
+        }
+        break;
+    case 2004:
+        bracketedPaste = enable;
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::selectGraphicRendition(const int *params, int paramCount) {
+    if (paramCount == 0) {
+        pen = Cell();
+        return;
+    }
+    for (int i = 0; i < paramCount; ++i) {
+        int p = params[i];
+        switch (p) {
+        case 0: pen = Cell(); break;
+        case 1: pen.attrs |= Cell::Bold; break;
+        case 2: pen.attrs |= Cell::Dim; break;
+        case 3: pen.attrs |= Cell::Italic; break;
+        case 4: pen.attrs |= Cell::Underline; break;
+        case 5: pen.attrs |= Cell::Blink; break;
+        case 7: pen.attrs |= Cell::Inverse; break;
+        case 8: pen.attrs |= Cell::Invisible; break;
+        case 9: pen.attrs |= Cell::Strikeout; break;
+        case 21: pen.attrs &= ~Cell::Bold; break;
+        case 22: pen.attrs &= ~(Cell::Bold | Cell::Dim); break;
+        case 23: pen.attrs &= ~Cell::Italic; break;
+        case 24: pen.attrs &= ~Cell::Underline; break;
+        case 25: pen.attrs &= ~Cell::Blink; break;
+        case 27: pen.attrs &= ~Cell::Inverse; break;
+        case 28: pen.attrs &= ~Cell::Invisible; break;
+        case 29: pen.attrs &= ~Cell::Strikeout; break;
+        case 39: pen.fg = Cell::DefaultColor; break;
+        case 49: pen.bg = Cell::DefaultColor; break;
+        case 38:
+        case 48: {
+            // 38;5;n (palette) or 38;2;r;g;b (direct colour)
+            uint32_t color = Cell::DefaultColor;
+            if (i + 2 < paramCount && params[i + 1] == 5) {
+                color = Cell::ColorIndexed | uint32_t(params[i + 2] & 0xFF);
+                i += 2;
+            } else if (i + 4 < paramCount && params[i + 1] == 2) {
+                color = Cell::ColorRgb | uint32_t((params[i + 2] & 0xFF) << 16 | (params[i + 3] & 0xFF) << 8 | (params[i + 4] & 0xFF));
+                i += 4;
+            } else {
+                i = paramCount; // Malformed: ignore the rest
+                break;
+            }
+            (p == 38 ? pen.fg : pen.bg) = color;
+            break;
+        }
+        default:
+            if (p >= 30 && p <= 37) {
+                pen.fg = Cell::ColorIndexed | uint32_t(p - 30);
+            } else if (p >= 40 && p <= 47) {
+                pen.bg = Cell::ColorIndexed | uint32_t(p - 40);
+            } else if (p >= 90 && p <= 97) {
+                pen.fg = Cell::ColorIndexed | uint32_t(p - 90 + 8);
+            } else if (p >= 100 && p <= 107) {
+                pen.bg = Cell::ColorIndexed | uint32_t(p - 100 + 8);
+            }
+            break;
+        }
+    }
+}
+
+void TerminalScreen::switchScreen(bool alternate) {
+    if (alternate == altActive) {
+        return;
+    }
+    cells.swap(altCells);
+    rowMap.swap(altRowMap);
+    altActive = alternate;
+    markAllDirty();
+}
+
+void TerminalScreen::saveCursor() {
+    saved.col = cursorCol;
+    saved.row = cursorRow;
+    saved.pen = pen;
+    saved.originMode = originMode;
+}
+
+void TerminalScreen::restoreCursor() {
+    cursorCol = std::min(saved.col, cols - 1);
+    cursorRow = std::min(saved.row, numRows - 1);
+    pen = saved.pen;
+    originMode = saved.originMode;
+    wrapPending = false;
+    markDirty(cursorRow);
+}
+
+void TerminalScreen::fullReset() {
+    if (altActive) {
+        switchScreen(false);
+    }
+    pen = Cell();
+    scrollTop = 0;
+    scrollBottom = numRows - 1;
+    autoWrap = showCursor = true;
+    originMode = bracketedPaste = false;
+    cursorCol = cursorRow = 0;
+    wrapPending = false;
+    saved = SavedCursor();
+    eraseInDisplay(2);
+}
+
+// Modes and the pen back to their defaults, like xterm's DECSTR; text and cursor stay
+void TerminalScreen::softReset() {
+    pen = Cell();
+    scrollTop = 0;
+    scrollBottom = numRows - 1;
+    autoWrap = showCursor = true;
+    originMode = false;
+    saved = SavedCursor();
+    markDirty(cursorRow);
+}
+
+void TerminalScreen::escDispatch(const char *intermediates, int intermediateCount, char final) {
+    interruptSequence();
+    if (intermediateCount > 0) {
+        return; // Charset designation (ESC ( B etc.): only UTF-8 is supported
+    }
+    switch (final) {
+    case '7': // DECSC
+        saveCursor();
+        break;
+    case '8': // DECRC
+        restoreCursor();
+        break;
+    case 'D': // IND
+        lineFeed();
+        break;
+    case 'E': // NEL
+        cursorCol = 0;
+        lineFeed();
+        break;
+    case 'M': // RI
+        reverseLineFeed();
+        break;
+    case 'c': // RIS
+        fullReset();
+        break;
+    default:
+        break; // Keypad modes and ST (ESC \) need no action
+    }
+    (void)intermediates;
+}
+
+void TerminalScreen::oscDispatch(const char *data, size_t len) {
+    interruptSequence();
+    // OSC 0 and 2 set the window title
+    if (len >= 2 && (data[0] == '0' || data[0] == '2') && data[1] == ';') {
+        windowTitle.assign(data + 2, len - 2);
+        titleDirty = true;
+    }
+}
@@ -0,0 +1,182 @@
+// TerminalScreen.h
+
+#ifndef TERMINALSCREEN_H
+#define TERMINALSCREEN_H
+
+#include "AnsiParser.h" // The screen is driven by the parser's actions
+#include "Utf8Decoder.h" // Printed text, decoded across PTY reads
+#include <cstdint> // Fixed width cell fields
+#include <functional> // Callback for lines leaving the screen
+#include <string> // Title and pending replies
+#include <vector> // Cell storage and dirty bits
+
+/**
+ * @file TerminalScreen.h
+ * @brief Cell-grid model of the terminal screen with per-row damage tracking.
+ *
+ * The screen is a contiguous rows x columns array of Cell values for the primary and
+ * the alternate buffer (used by full-screen programs such as vim and top). Screen rows
+ * are found through a row table, so scrolling rotates row numbers instead of moving
+ * every cell of the region, and a line feed on a large grid costs one row. Every change
+ * marks its row dirty, so the view only has to repaint the rows that changed since the
+ * last frame instead of the whole document. Printed text is decoded from UTF-8 straight
+ * into cells; a character split across two reads is completed by the second one, and
+ * runs of ASCII are written without decoding.
+ */
+
+/**
+ * @brief One character cell: codepoint, colours and attributes in 16 bytes.
+ *
+ * Colours use the top byte as a tag: 0 is the default colour, ColorIndexed carries a
+ * palette index (0-255) and ColorRgb a 24-bit RGB value in the low bytes.
+ */
+struct Cell {
+    enum Attribute : uint16_t {
+        Bold = 1 << 0,
+        Dim = 1 << 1,
+        Italic = 1 << 2,
+        Underline = 1 << 3,
+        Blink = 1 << 4,
+        Inverse = 1 << 5,
+        Invisible = 1 << 6,
+        Strikeout = 1 << 7,
+        Wide = 1 << 8, // First half of a double width character
+        WideTail = 1 << 9 // Placeholder occupying the second half
+    };
+
+    static constexpr uint32_t DefaultColor = 0;
+    static constexpr uint32_t ColorIndexed = 1u << 24;
+    static constexpr uint32_t ColorRgb = 2u << 24;
+
+    uint32_t codepoint = ' ';
+    uint32_t fg = DefaultColor;
+    uint32_t bg = DefaultColor;
+    uint16_t attrs = 0;
+
+    // Cells with the same style can be drawn as one run
+    bool sameStyle(const Cell &other) const {
+        return fg == other.fg && bg == other.bg && ((attrs ^ other.attrs) & ~(Wide | WideTail)) == 0;
+    }
+};
+
+/**
+ * @brief Changes of a TerminalScreen since the previous update, for another thread.
+ *
+ * The PTY thread parses into its own screen and ships the damaged rows to the GUI
+ * thread's copy in one of these, so the GUI never reads cells that are being written.
+ */
+struct ScreenUpdate {
+    int columns = 0, rows = 0;
+    std::vector<int> rowIndexes; // Damaged rows, in order
+    std::vector<Cell> cells; // columns cells for each entry of rowIndexes
+    int cursorX = 0, cursorY = 0;
+    bool cursorVisible = true;
+    bool alternateScreen = false;
+    bool bracketedPaste = false;
+    bool titleChanged = false;
+    std::string title;
+    std::string history; // Lines scrolled off the top, UTF-8 encoded, back to back
+    std::vector<size_t> historyEnds; // End of each line in history
+    size_t bytes = 0; // PTY bytes parsed into this update
+    bool eof = false; // The shell closed the PTY
+};
+
+class TerminalScreen : public AnsiHandler {
+public:
+    TerminalScreen(int columns = 80, int rows = 24);
+
+    void resize(int columns, int rows); // Keeps the cursor's row; rows pushed off the top go to the history
+
+    int columns() const { return cols; }
+    int rows() const { return numRows; }
+    const Cell *row(int index) const { return cells.data() + size_t(rowMap[size_t(index)]) * cols; }
+
+    int cursorX() const { return cursorCol; }
+    int cursorY() const { return cursorRow; }
+    bool cursorVisible() const { return showCursor; }
+    bool alternateScreenActive() const { return altActive; }
+    bool bracketedPasteEnabled() const { return bracketedPaste; }
+
+    // Damage tracking: rows modified since the last clearDamage()
+    bool isRowDirty(int index) const { return dirty[size_t(index)] != 0; }
+    bool hasDamage() const { return damaged; }
+    void clearDamage();
+
+    // Window title from OSC 0/2; titleChanged() reports and resets the change flag
+    const std::string &title() const { return windowTitle; }
+    bool titleChanged();
+
+    // Replies to queries such as DSR/DA that must be written back to the PTY
+    std::string takeResponses();
+
+    void takeUpdate(ScreenUpdate &update); // Moves the damaged rows and cursor state out, clearing the damage
+    void applyUpdate(const ScreenUpdate &update); // Copies an update from another screen in
+
+    // Called with each line that scrolls off the top of the primary screen
+    std::function<void(const Cell *cells, int count)> onLineScrolledOut;
+
+    // AnsiHandler interface
+    void print(const char *data, size_t len) override;
+    void execute(unsigned char control) override;
+    void csiDispatch(const int *params, int paramCount, char privateMarker,
+                     const char *intermediates, int intermediateCount, char final) override;
+    void escDispatch(const char *intermediates, int intermediateCount, char final) override;
+    void oscDispatch(const char *data, size_t len) override;
+
+    void putCodepoint(uint32_t codepoint); // Writes one character at the cursor and advances it
+    static int charWidth(uint32_t codepoint); // Columns taken by a codepoint: 0, 1 or 2
+
+private:
+    Cell *rowPtr(int index) { return cells.data() + size_t(rowMap[size_t(index)]) * cols; }
+    Cell blankCell() const; // Erased cell carrying the current background colour
+    void markDirty(int index) { dirty[size_t(index)] = 1; damaged = true; }
+    void markAllDirty();
+    void putAscii(const char *text, size_t len); // Printable ASCII run, one cell per byte
+    void breakWide(Cell *line, int from, int to); // Blanks wide characters cut by a change to [from, to)
+    void interruptSequence(); // A control or escape sequence cut a UTF-8 character short
+
+    void lineFeed();
+    void reverseLineFeed();
+    void scrollUp(int top, int bottom, int count);
+    void scrollDown(int top, int bottom, int count);
+    void eraseInRow(int index, int from, int to); // Half-open column range
+    void eraseInDisplay(int mode);
+    void eraseInLine(int mode);
+    void insertBlanks(int count);
+    void deleteChars(int count);
+    void moveCursor(int col, int row);
+    void setMode(int mode, bool privateMode, bool enable);
+    void selectGraphicRendition(const int *params, int paramCount);
+    void switchScreen(bool alternate);
+    void saveCursor();
+    void restoreCursor();
+    void softReset();
+    void fullReset();
+
+    int cols, numRows;
+    std::vector<Cell> cells; // Active buffer, rows x cols
+    std::vector<Cell> altCells; // Inactive buffer, swapped in on screen switch
+    std::vector<int> rowMap; // Storage row of each screen row in cells
+    std::vector<int> altRowMap; // The same for altCells
+    std::vector<uint8_t> dirty; // One flag per row
+    bool damaged;
+
+    int cursorCol, cursorRow;
+    bool wrapPending; // Cursor sits past the last column; next print wraps first
+    Cell pen; // Colours and attributes applied to new characters
+    Utf8Decoder utf8; // Holds a character split across print() calls
+    int scrollTop, scrollBottom; // Scrolling region, inclusive rows
+    bool autoWrap, showCursor, altActive, bracketedPaste, originMode;
+
+    struct SavedCursor {
+        int col = 0, row = 0;
+        Cell pen;
+        bool originMode = false;
+    } saved;
+
+    std::string windowTitle;
+    bool titleDirty;
+    std::string responses;
+};
+
+#endif // TERMINALSCREEN_H
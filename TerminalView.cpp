@@ -0,0 +1,366 @@
+// TerminalView.cpp
+#include "TerminalView.h"
+
+#include <QPainter> //Draws the cells.
+#include <QPaintEvent> //Provides the region that needs repainting.
+#include <QKeyEvent> //Keyboard input forwarded to the shell.
+#include <QFontMetrics> //Measures the cell size.
+#include <QWheelEvent> //Scrolls through the history.
+#include <QGuiApplication> //Access to the clipboard.
+#include <QClipboard> //Text to paste.
+#include <climits> //INT_MAX
+#include "Instrumentation.h" //Frame timer.
+#include "Utf8Decoder.h" //History lines to cells.
+
+TerminalView::TerminalView(TerminalScreen *screen, QWidget *parent) : QWidget(parent), screen(screen), cellWidth(1), cellHeight(1), ascent(0), paintedCursorX(0), paintedCursorY(0), history(nullptr), scrollOffset(0), historyLines(0), hasMatch(false), matchLine(0), matchOffset(0), matchLength(0), matchFrom(0), matchTo(0), atlas(nullptr) {
+    font = terminalFont();
+    QFontMetrics metrics(font);
+    cellWidth = qMax(1, metrics.horizontalAdvance(QLatin1Char('M')));
+    cellHeight = qMax(1, metrics.height());
+    ascent = metrics.ascent();
+
+    // Base 16 colours, then the 6x6x6 colour cube and the grey ramp, as in xterm
+    static const QRgb base[16] = {
+        0x000000, 0xcd0000, 0x00cd00, 0xcdcd00, 0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
+        0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00, 0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff};
+    for (int i = 0; i < 16; ++i) {
+        palette[i] = QColor(base[i]);
+    }
+    static const int levels[6] = {0, 95, 135, 175, 215, 255};
+    for (int i = 0; i < 216; ++i) {
+        palette[16 + i] = QColor(levels[i / 36], levels[(i / 6) % 6], levels[i % 6]);
+    }
+    for (int i = 0; i < 24; ++i) {
+        int grey = 8 + i * 10;
+        palette[232 + i] = QColor(grey, grey, grey);
+    }
+    defaultForeground = palette[7];
+    defaultBackground = palette[0];
+
+    setAttribute(Qt::WA_OpaquePaintEvent); // Every pixel is painted, skip the background erase
+    setFocusPolicy(Qt::StrongFocus);
+}
+
+QFont TerminalView::terminalFont() {
+    QFont font("Monospace");
+    font.setStyleHint(QFont::TypeWriter);
+    font.setFixedPitch(true);
+    return font;
+}
+
+std::unique_ptr<GlyphAtlas> TerminalView::createGlyphAtlas() {
+    QFont font = terminalFont();
+    QFontMetrics metrics(font);
+    return std::unique_ptr<GlyphAtlas>(new GlyphAtlas(font, qMax(1, metrics.horizontalAdvance(QLatin1Char('M'))), qMax(1, metrics.height()), metrics.ascent()));
+}
+
+void TerminalView::setGlyphAtlas(GlyphAtlas *shared) {
+    atlas = shared;
+    ownAtlas.reset();
+    update();
+}
+
+QSize TerminalView::sizeHint() const {
+    return QSize(80 * cellWidth, 24 * cellHeight);
+}
+
+void TerminalView::setScrollback(const Scrollback *scrollback) {
+    history = scrollback;
+    historyLines = history ? history->lineCount() : 0;
+    scrollOffset = 0;
+}
+
+void TerminalView::scrollBy(int lines) {
+    int limit = history ? int(qMin<size_t>(history->lineCount(), INT_MAX)) : 0;
+    int offset = qBound(0, scrollOffset + lines, limit);
+    if (offset != scrollOffset) {
+        scrollOffset = offset;
+        update(); // Every row moves
+    }
+}
+
+void TerminalView::showMatch(quint64 line, int offset, int length) {
+    if (!history || line < history->firstLineNumber() || line >= history->endLineNumber()) {
+        return;
+    }
+    hasMatch = true;
+    matchLine = line;
+    matchOffset = offset;
+    matchLength = length;
+
+    // Put the line a third of the way down the view
+    size_t lines = history->lineCount();
+    size_t fromBottom = lines - size_t(line - history->firstLineNumber());
+    scrollOffset = int(qMin<size_t>(qMin<size_t>(lines, fromBottom + size_t(screen->rows() / 3)), INT_MAX));
+    historyLines = lines;
+    update();
+}
+
+void TerminalView::clearMatch() {
+    if (hasMatch) {
+        hasMatch = false;
+        update();
+    }
+}
+
+void TerminalView::updateDamage() {
+    if (scrollOffset > 0) {
+        // Keep the same history lines in view while new output scrolls in below
+        size_t lines = history->lineCount();
+        if (lines != historyLines) {
+            scrollOffset = int(qMin<size_t>(lines, size_t(scrollOffset) + (lines > historyLines ? lines - historyLines : 0)));
+            historyLines = lines;
+            update();
+        } else if (screen->hasDamage()) {
+            update(); // Screen rows are shifted by the offset, so repaint everything visible
+        }
+        screen->clearDamage();
+        return;
+    }
+    historyLines = history ? history->lineCount() : 0;
+
+    if (screen->hasDamage()) {
+        for (int row = 0; row < screen->rows(); ++row) {
+            if (screen->isRowDirty(row)) {
+                update(rowRect(row));
+            }
+        }
+        screen->clearDamage();
+    }
+
+    // The cursor is drawn by the view, so a moved cursor damages its old and new rows
+    if (screen->cursorX() != paintedCursorX || screen->cursorY() != paintedCursorY) {
+        update(rowRect(paintedCursorY));
+        update(rowRect(screen->cursorY()));
+        paintedCursorX = screen->cursorX();
+        paintedCursorY = screen->cursorY();
+    }
+}
+
+QColor TerminalView::resolveColor(uint32_t color, bool foreground) const {
+    switch (color & 0xFF000000u) {
+    case Cell::ColorIndexed:
+        return palette[color & 0xFF];
+    case Cell::ColorRgb:
+        return QColor::fromRgb(QRgb(color & 0xFFFFFF));
+    default:
+        return foreground ? defaultForeground : defaultBackground;
+    }
+}
+
+void TerminalView::paintEvent(QPaintEvent *event) {
+    TERME_SCOPE(Render);
+    TERME_COUNT(FramesPainted, 1);
+    QPainter painter(this);
+    if (!atlas) {
+        // Created on first paint rather than with the widget, so a view that is given a
+        // shared atlas, or never shown, does not build one
+        ownAtlas = createGlyphAtlas();
+        atlas = ownAtlas.get();
+    }
+    atlas->beginFrame();
+
+    const QRect area = event->rect();
+    int firstRow = qMax(0, area.top() / cellHeight);
+    int lastRow = qMin(screen->rows() - 1, area.bottom() / cellHeight);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        paintRow(painter, row);
+    }
+
+    // Area outside the grid
+    int gridRight = screen->columns() * cellWidth;
+    int gridBottom = screen->rows() * cellHeight;
+    if (area.right() >= gridRight) {
+        painter.fillRect(QRect(gridRight, area.top(), width() - gridRight, area.height()), defaultBackground);
+    }
+    if (area.bottom() >= gridBottom) {
+        painter.fillRect(QRect(0, gridBottom, width(), height() - gridBottom), defaultBackground);
+    }
+}
+
+const Cell *TerminalView::historyRow(size_t line) {
+    historyCells.assign(size_t(screen->columns()), Cell());
+    std::string text = history->line(line);
+    const bool marked = hasMatch && history->firstLineNumber() + line == matchLine;
+    matchFrom = matchTo = 0;
+    int col = 0;
+    int byte = 0; // Offset of cp in text, to find the cells of the search match
+    bool full = false;
+    // Decoded straight into the cells; history lines were encoded whole, so nothing is left over
+    Utf8Decoder decoder;
+    decoder.decodeAll(text.data(), text.size(), [&](uint32_t cp) {
+        const int start = byte;
+        byte += cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+        int width = TerminalScreen::charWidth(cp);
+        if (width == 0 || full) {
+            return;
+        }
+        if (col + width > screen->columns()) {
+            full = true;
+            return;
+        }
+        if (marked && start >= matchOffset && start < matchOffset + matchLength) {
+            matchFrom = matchTo > matchFrom ? matchFrom : col;
+            matchTo = col + width;
+        }
+        historyCells[size_t(col)].codepoint = cp;
+        if (width == 2) {
+            historyCells[size_t(col)].attrs = Cell::Wide;
+            historyCells[size_t(col) + 1].attrs = Cell::WideTail;
+        }
+        col += width;
+    });
+    return historyCells.data();
+}
+
+void TerminalView::paintRow(QPainter &painter, int row) {
+    // With a scroll offset the top rows come from the history and the screen moves down
+    const int screenRow = row - scrollOffset;
+    const Cell *cells = screenRow < 0 ? historyRow(history->lineCount() - size_t(-screenRow)) : screen->row(screenRow);
+    const bool marked = screenRow < 0 && matchTo > matchFrom;
+    const int y = row * cellHeight;
+    const int columns = screen->columns();
+    const int cursorCol = (screen->cursorVisible() && screenRow == screen->cursorY() && hasFocus()) ? screen->cursorX() : -1;
+
+    int col = 0;
+    while (col < columns) {
+        // A run is a stretch of cells sharing one style; the cursor cell is a run of its own
+        const int start = col;
+        const Cell &style = cells[start];
+        ++col;
+        if (start != cursorCol) {
+            while (col < columns && col != cursorCol && cells[col].sameStyle(style)) {
+                ++col;
+            }
+        } else if (col < columns && (cells[col].attrs & Cell::WideTail)) {
+            ++col; // The cursor covers both halves of a wide character
+        }
+
+        QColor fg = resolveColor(style.fg, true);
+        QColor bg = resolveColor(style.bg, false);
+        if (style.attrs & Cell::Bold && (style.fg & 0xFF000000u) == Cell::ColorIndexed && (style.fg & 0xFF) < 8) {
+            fg = palette[(style.fg & 0xFF) + 8]; // Bold brightens the base colours
+        }
+        if (style.attrs & Cell::Inverse) {
+            std::swap(fg, bg);
+        }
+        if (start == cursorCol) {
+            std::swap(fg, bg);
+        }
+
+        const QRect runRect(start * cellWidth, y, (col - start) * cellWidth, cellHeight);
+        painter.fillRect(runRect, bg);
+        if (style.attrs & Cell::Invisible) {
+            continue;
+        }
+
+        // Blit the run's glyphs from the atlas, one drawPixmapFragments() call per page
+        const uint16_t glyphStyle = ((style.attrs & Cell::Bold) ? GlyphAtlas::Bold : 0) | ((style.attrs & Cell::Italic) ? GlyphAtlas::Italic : 0);
+        const QRgb color = fg.rgb();
+        const qreal ratio = devicePixelRatioF(); // Changes when the window moves to another screen
+        int batchPage = -1;
+        fragments.clear();
+        for (int i = start; i < col; ++i) {
+            const Cell &cell = cells[i];
+            if (cell.codepoint == ' ' || (cell.attrs & Cell::WideTail)) {
+                continue;
+            }
+            const int span = (cell.attrs & Cell::Wide) ? 2 : 1;
+            GlyphAtlas::Glyph glyph = atlas->glyph(cell.codepoint, glyphStyle, color, span, ratio);
+            if (glyph.page != batchPage && !fragments.empty()) {
+                painter.drawPixmapFragments(fragments.data(), int(fragments.size()), atlas->page(batchPage));
+                fragments.clear();
+            }
+            batchPage = glyph.page;
+            // The source is in device pixels; scaling by 1 / ratio draws it cell sized
+            QPointF center(i * cellWidth + span * cellWidth / 2.0, y + cellHeight / 2.0);
+            fragments.push_back(QPainter::PixmapFragment::create(center, glyph.source, 1 / ratio, 1 / ratio));
+        }
+        if (!fragments.empty()) {
+            painter.drawPixmapFragments(fragments.data(), int(fragments.size()), atlas->page(batchPage));
+        }
+
+        if (style.attrs & Cell::Underline) {
+            painter.fillRect(QRect(runRect.left(), y + ascent + 1, runRect.width(), 1), fg);
+        }
+        if (style.attrs & Cell::Strikeout) {
+            painter.fillRect(QRect(runRect.left(), y + ascent - ascent / 3, runRect.width(), 1), fg);
+        }
+    }
+
+    if (marked) {
+        painter.fillRect(QRect(matchFrom * cellWidth, y, (matchTo - matchFrom) * cellWidth, cellHeight), QColor(255, 200, 0, 110));
+    }
+}
+
+void TerminalView::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    emit gridResized(qMax(1, width() / cellWidth), qMax(1, height() / cellHeight));
+}
+
+bool TerminalView::focusNextPrevChild(bool) {
+    return false;
+}
+
+void TerminalView::focusInEvent(QFocusEvent *event) {
+    QWidget::focusInEvent(event);
+    update(rowRect(screen->cursorY()));
+}
+
+void TerminalView::focusOutEvent(QFocusEvent *event) {
+    QWidget::focusOutEvent(event);
+    update(rowRect(screen->cursorY()));
+}
+
+void TerminalView::wheelEvent(QWheelEvent *event) {
+    scrollBy(event->angleDelta().y() / 40); // Three lines per wheel notch
+    event->accept();
+}
+
+void TerminalView::keyPressEvent(QKeyEvent *event) {
+    if (event->modifiers() & Qt::ShiftModifier) {
+        if (event->key() == Qt::Key_PageUp || event->key() == Qt::Key_PageDown) {
+            int page = qMax(1, screen->rows() - 1);
+            scrollBy(event->key() == Qt::Key_PageUp ? page : -page);
+            return;
+        }
+    }
+    scrollBy(-scrollOffset); // Typing returns to the live screen
+
+    bool pasteKey = (event->key() == Qt::Key_V && event->modifiers() == (Qt::ControlModifier | Qt::ShiftModifier))
+                    || (event->key() == Qt::Key_Insert && event->modifiers() == Qt::ShiftModifier);
+    if (pasteKey) {
+        QString text = QGuiApplication::clipboard()->text();
+        if (!text.isEmpty()) {
+            emit pasteRequested(text);
+        }
+        return;
+    }
+
+    QByteArray data;
+    switch (event->key()) {
+    case Qt::Key_Return:
+    case Qt::Key_Enter: data = "\r"; break;
+    case Qt::Key_Backspace: data = "\x7f"; break;
+    case Qt::Key_Tab: data = "\t"; break;
+    case Qt::Key_Escape: data = "\033"; break;
+    case Qt::Key_Up: data = "\033[A"; break;
+    case Qt::Key_Down: data = "\033[B"; break;
+    case Qt::Key_Right: data = "\033[C"; break;
+    case Qt::Key_Left: data = "\033[D"; break;
+    case Qt::Key_Home: data = "\033[H"; break;
+    case Qt::Key_End: data = "\033[F"; break;
+    case Qt::Key_Insert: data = "\033[2~"; break;
+    case Qt::Key_Delete: data = "\033[3~"; break;
+    case Qt::Key_PageUp: data = "\033[5~"; break;
+    case Qt::Key_PageDown: data = "\033[6~"; break;
+    default:
+        data = event->text().toUtf8(); // Includes control characters such as Ctrl+C
+        break;
+    }
+    if (!data.isEmpty()) {
+        emit keyInput(data);
+    } else {
+        QWidget::keyPressEvent(event);
+    }
+}
@@ -0,0 +1,87 @@
+// TerminalView.h
+
+#ifndef TERMINALVIEW_H
+#define TERMINALVIEW_H
+
+#include <QWidget> // Base class for the custom painted view
+#include <QFont> // Monospace font used for the grid
+#include <QColor> // Palette entries
+#include "TerminalScreen.h" // The model being drawn
+#include "Scrollback.h" // History shown when scrolled back
+#include "GlyphAtlas.h" // Pre-rasterised glyphs for run-batched drawing
+#include <QPainter> // PixmapFragment batches
+#include <memory>
+#include <vector>
+
+/**
+ * @file TerminalView.h
+ * @brief Custom painted widget that draws a TerminalScreen cell grid.
+ *
+ * updateDamage() turns the screen's dirty rows into update() calls for just those
+ * rows, so a frame costs O(changed rows) rather than a relayout of the whole
+ * document. Rows are drawn as runs of identically styled cells, each run being one
+ * background fill plus one batched blit of its glyphs from a GlyphAtlas, which views
+ * of several sessions can share through setGlyphAtlas().
+ *
+ * Key presses are translated into the byte sequences a VT terminal sends and emitted
+ * through keyInput(); Ctrl+Shift+V and Shift+Insert emit the clipboard text through
+ * pasteRequested(). The mouse wheel and Shift+PageUp/PageDown scroll back into the
+ * Scrollback history; any other key returns to the live screen. showMatch() scrolls a
+ * search result into view and highlights it.
+ */
+class TerminalView : public QWidget {
+    Q_OBJECT
+public:
+    explicit TerminalView(TerminalScreen *screen, QWidget *parent = nullptr);
+
+    void updateDamage(); // Schedules repaints for the rows changed since the last call
+    void setScrollback(const Scrollback *history); // Enables scrolling back into history
+    void scrollBy(int lines); // Positive values move back into the history
+    void showMatch(quint64 line, int offset, int length); // Scrolls to and marks bytes of an absolute history line
+    void clearMatch();
+    void setGlyphAtlas(GlyphAtlas *shared); // Draws from a cache shared with other views
+    QSize sizeHint() const override;
+
+    static QFont terminalFont();
+    static std::unique_ptr<GlyphAtlas> createGlyphAtlas(); // An atlas matching terminalFont()
+
+signals:
+    void keyInput(const QByteArray &data); // Bytes to send to the shell
+    void pasteRequested(const QString &text); // Clipboard text the user asked to paste
+    void gridResized(int columns, int rows); // The widget now fits a different grid size
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    bool focusNextPrevChild(bool next) override; // Keeps Tab for the shell
+    void focusInEvent(QFocusEvent *event) override; // The cursor is only drawn while focused
+    void focusOutEvent(QFocusEvent *event) override;
+
+private:
+    QColor resolveColor(uint32_t color, bool foreground) const;
+    void paintRow(QPainter &painter, int row);
+    const Cell *historyRow(size_t line); // Decodes a scrollback line into historyCells
+    QRect rowRect(int row) const { return QRect(0, row * cellHeight, width(), cellHeight); }
+
+    TerminalScreen *screen;
+    QFont font;
+    int cellWidth, cellHeight, ascent; // Cell metrics in pixels
+    int paintedCursorX, paintedCursorY; // Cursor position at the last repaint
+    const Scrollback *history;
+    int scrollOffset; // Lines scrolled back into the history, 0 shows the live screen
+    size_t historyLines; // History size at the last update, to keep the view anchored
+    std::vector<Cell> historyCells; // Scratch row for drawing history lines
+    bool hasMatch;
+    quint64 matchLine; // Absolute line number of the highlighted search match
+    int matchOffset, matchLength; // Its bytes within the line
+    int matchFrom, matchTo; // Its cells in the row last decoded by historyRow(); empty if not there
+    GlyphAtlas *atlas; // ownAtlas, a cache shared by all sessions, or null before the first paint
+    std::unique_ptr<GlyphAtlas> ownAtlas;
+    std::vector<QPainter::PixmapFragment> fragments; // Glyph blits of the run being drawn
+    QColor palette[256]; // xterm 256-colour palette
+    QColor defaultForeground, defaultBackground;
+};
+
+#endif // TERMINALVIEW_H
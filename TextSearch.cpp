@@ -0,0 +1,209 @@
+// TextSearch.cpp
+#include "TextSearch.h"
+
+#include <cstring> //memchr, memcmp.
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TEXTSEARCH_X86
+#include <immintrin.h> //SSE2 and AVX2 intrinsics.
+#endif
+
+namespace {
+
+const char *findScalar(const char *text, size_t size, const char *needle, size_t length) {
+    const char *last = text + (size - length); // Last possible start
+    const char *p = text;
+    while (p <= last) {
+        p = static_cast<const char *>(memchr(p, needle[0], size_t(last - p) + 1));
+        if (!p) {
+            return nullptr;
+        }
+        if (memcmp(p + 1, needle + 1, length - 1) == 0) {
+            return p;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+#ifdef TEXTSEARCH_X86
+// Both vector versions test the first and the last byte of the needle at every position
+// of a block and only compare the middle where both are equal. A block is processed while
+// its last-byte load stays inside the text; the remainder goes to the scalar loop.
+
+__attribute__((target("sse2"))) const char *findSse2(const char *text, size_t size, const char *needle, size_t length) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[length - 1]);
+    size_t i = 0;
+    for (; i + length - 1 + 16 <= size; i += 16) {
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + length - 1));
+        unsigned mask = unsigned(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+        while (mask) {
+            const size_t pos = i + size_t(__builtin_ctz(mask));
+            if (memcmp(text + pos + 1, needle + 1, length - 2) == 0) {
+                return text + pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i + length <= size ? findScalar(text + i, size - i, needle, length) : nullptr;
+}
+
+__attribute__((target("avx2"))) const char *findAvx2(const char *text, size_t size, const char *needle, size_t length) {
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+    size_t i = 0;
+    for (; i + length - 1 + 32 <= size; i += 32) {
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + length - 1));
+        unsigned mask = unsigned(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last))));
+        while (mask) {
+            const size_t pos = i + size_t(__builtin_ctz(mask));
+            if (memcmp(text + pos + 1, needle + 1, length - 2) == 0) {
+                return text + pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i + length <= size ? findScalar(text + i, size - i, needle, length) : nullptr;
+}
+#endif
+
+TextSearch::Isa detectIsa() {
+#ifdef TEXTSEARCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return TextSearch::Avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return TextSearch::Sse2;
+    }
+#endif
+    return TextSearch::Scalar;
+}
+
+} // namespace
+
+TextSearch::Isa TextSearch::bestIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+bool TextSearch::supported(Isa isa) {
+    return isa <= bestIsa();
+}
+
+const char *TextSearch::isaName(Isa isa) {
+    switch (isa) {
+    case Sse2: return "SSE2";
+    case Avx2: return "AVX2";
+    default: return "scalar";
+    }
+}
+
+const char *TextSearch::find(const char *text, size_t size, const char *needle, size_t length) {
+    return find(bestIsa(), text, size, needle, length);
+}
+
+const char *TextSearch::find(Isa isa, const char *text, size_t size, const char *needle, size_t length) {
+    if (length == 0) {
+        return text;
+    }
+    if (length > size) {
+        return nullptr;
+    }
+    if (length == 1) {
+        return static_cast<const char *>(memchr(text, needle[0], size)); // Already vectorised by libc
+    }
+    switch (isa) {
+#ifdef TEXTSEARCH_X86
+    case Avx2: return findAvx2(text, size, needle, length);
+    case Sse2: return findSse2(text, size, needle, length);
+#endif
+    default: return findScalar(text, size, needle, length);
+    }
+}
+
+std::string TextSearch::requiredLiteral(const std::string &regex) {
+    // Any alternative could match without a given literal
+    if (regex.find('|') != std::string::npos) {
+        return std::string();
+    }
+
+    std::string best, run;
+    auto endRun = [&]() {
+        if (run.size() > best.size()) {
+            best = run;
+        }
+        run.clear();
+    };
+
+    // Only top level characters count: a group may be optional, repeated or a lookahead
+    int depth = 0;
+    const size_t size = regex.size();
+    size_t i = 0;
+    while (i < size) {
+        char c = regex[i];
+        char atom = 0;
+        bool literal = false;
+        size_t next = i + 1;
+        if (c == '\\') {
+            if (next >= size) {
+                break;
+            }
+            char escaped = regex[next++];
+            if (escaped != 0 && strchr("^$\\.*+?()[]{}/-", escaped)) {
+                atom = escaped;
+                literal = true;
+            } // Anything else is a class (\d, \w), an assertion (\b) or a code (\n, \x41)
+        } else if (c == '[') {
+            // Skip the bracket expression; a ']' right after '[' or '[^' is a member
+            if (next < size && regex[next] == '^') {
+                ++next;
+            }
+            if (next < size && regex[next] == ']') {
+                ++next;
+            }
+            while (next < size && regex[next] != ']') {
+                next += regex[next] == '\\' ? 2 : 1;
+            }
+            ++next;
+        } else if (c == '(' || c == ')') {
+            depth += c == '(' ? 1 : -1;
+            endRun();
+            i = next;
+            continue;
+        } else if (!strchr("^$.*+?{}", c)) {
+            atom = c;
+            literal = true;
+        }
+
+        // A following quantifier decides whether the atom is required
+        bool optional = false, repeated = false;
+        if (next < size && (regex[next] == '*' || regex[next] == '?' || regex[next] == '+')) {
+            optional = regex[next] != '+';
+            repeated = true;
+            ++next;
+            if (next < size && regex[next] == '?') {
+                ++next; // Lazy
+            }
+        } else if (next < size && regex[next] == '{') {
+            optional = true; // {0,n} is possible; not worth parsing
+            size_t close = regex.find('}', next);
+            next = close == std::string::npos ? size : close + 1;
+        }
+
+        if (!literal || depth > 0 || optional) {
+            endRun();
+        } else {
+            run.push_back(atom);
+            if (repeated) {
+                endRun(); // "ab+c" needs "ab" but not "abc"
+            }
+        }
+        i = next;
+    }
+    endRun();
+    return best;
+}
@@ -0,0 +1,44 @@
+// TextSearch.h
+
+#ifndef TEXTSEARCH_H
+#define TEXTSEARCH_H
+
+#include <cstddef> // size_t
+#include <string> // Literal extracted from a regex
+
+/**
+ * @file TextSearch.h
+ * @brief Vectorised substring search over raw UTF-8 text.
+ *
+ * find() compares the first and the last byte of the needle against 16 (SSE2) or 32
+ * (AVX2) positions at once and only calls memcmp() for the positions where both
+ * match, which on terminal text is rarely more than a handful per block. The widest
+ * instruction set the CPU supports is picked once at startup; other CPUs use a
+ * memchr() based scalar loop. Bytes are compared as they are, so the search is
+ * case sensitive and a needle matches any UTF-8 text that contains it.
+ *
+ * requiredLiteral() finds a string every match of a regex must contain, so a regex
+ * search can use find() to skip the lines that cannot match.
+ */
+class TextSearch {
+public:
+    enum Isa {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    // First occurrence of needle in text, or nullptr. An empty needle matches at text
+    static const char *find(const char *text, size_t size, const char *needle, size_t length);
+    static const char *find(Isa isa, const char *text, size_t size, const char *needle, size_t length); // isa must be supported
+
+    static Isa bestIsa(); // What find() uses on this CPU
+    static bool supported(Isa isa);
+    static const char *isaName(Isa isa);
+
+    // Longest run of plain characters that every match of the ECMAScript regex contains;
+    // empty when there is none the prefilter can rely on, e.g. with alternation
+    static std::string requiredLiteral(const std::string &regex);
+};
+
+#endif // TEXTSEARCH_H
@@ -0,0 +1,139 @@
+// Utf8Decoder.h
+
+#ifndef UTF8DECODER_H
+#define UTF8DECODER_H
+
+#include <cstddef> // size_t
+#include <cstdint> // Codepoints
+#include <cstring> // memcpy for the word-at-a-time ASCII check
+
+#ifdef __SSE2__
+#include <emmintrin.h> // 16-byte ASCII check
+#endif
+
+/**
+ * @file Utf8Decoder.h
+ * @brief Streaming UTF-8 decoder that keeps a partial sequence across calls.
+ *
+ * PTY reads end wherever the kernel buffer did, often in the middle of a multibyte
+ * character. The decoder keeps the bytes of an unfinished sequence as state, so the
+ * next call completes the character instead of both halves turning into U+FFFD.
+ * Malformed input (stray continuation bytes, overlong forms, surrogates, values above
+ * U+10FFFF, a sequence cut short by another byte) gives one U+FFFD per maximal invalid
+ * subpart, as the Unicode standard recommends.
+ *
+ * Plain ASCII is the common case, so decode() stops at the start of an ASCII run and
+ * asciiPrefix() measures the run 16 bytes at a time (SSE2) or 8 at a time otherwise;
+ * the caller can then store the run without decoding it byte by byte. No call
+ * allocates.
+ */
+class Utf8Decoder {
+public:
+    static constexpr uint32_t Replacement = 0xFFFD;
+
+    // Number of leading bytes below 0x80
+    static size_t asciiPrefix(const char *data, size_t len) {
+        size_t i = 0;
+#ifdef __SSE2__
+        for (; i + 16 <= len; i += 16) {
+            int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+            if (mask) {
+                return i + size_t(__builtin_ctz(unsigned(mask)));
+            }
+        }
+#endif
+        for (; i + 8 <= len; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            if (word & 0x8080808080808080ull) {
+                break;
+            }
+        }
+        while (i < len && static_cast<unsigned char>(data[i]) < 0x80) {
+            ++i;
+        }
+        return i;
+    }
+
+    bool pending() const { return needed != 0; } // In the middle of a sequence
+
+    // Decodes from data towards end, calling output(codepoint) for each character. Stops
+    // at an ASCII byte that does not interrupt a sequence, or at end; returns where it
+    // stopped. A sequence cut off by end is finished by the next call
+    template <typename Emit>
+    const char *decode(const char *data, const char *end, Emit output) {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+        const unsigned char *stop = reinterpret_cast<const unsigned char *>(end);
+        while (p < stop) {
+            const unsigned char byte = *p;
+            if (needed == 0) {
+                if (byte < 0x80) {
+                    break;
+                }
+                ++p;
+                lower = 0x80;
+                upper = 0xBF;
+                if (byte >= 0xC2 && byte <= 0xDF) {
+                    needed = 1;
+                    codepoint = byte & 0x1F;
+                } else if (byte >= 0xE0 && byte <= 0xEF) {
+                    needed = 2;
+                    codepoint = byte & 0x0F;
+                    lower = byte == 0xE0 ? 0xA0 : 0x80; // No overlong forms
+                    upper = byte == 0xED ? 0x9F : 0xBF; // No surrogates
+                } else if (byte >= 0xF0 && byte <= 0xF4) {
+                    needed = 3;
+                    codepoint = byte & 0x07;
+                    lower = byte == 0xF0 ? 0x90 : 0x80;
+                    upper = byte == 0xF4 ? 0x8F : 0xBF; // Nothing above U+10FFFF
+                } else {
+                    output(Replacement); // Continuation byte without a lead, or an invalid lead
+                }
+            } else if (byte < lower || byte > upper) {
+                // The sequence so far is one bad character; the byte starts afresh
+                needed = 0;
+                output(Replacement);
+            } else {
+                ++p;
+                codepoint = (codepoint << 6) | (byte & 0x3F);
+                lower = 0x80;
+                upper = 0xBF;
+                if (--needed == 0) {
+                    output(codepoint);
+                }
+            }
+        }
+        return reinterpret_cast<const char *>(p);
+    }
+
+    // Decodes everything, ASCII included; for text that is not stored run by run
+    template <typename Emit>
+    void decodeAll(const char *data, size_t len, Emit output) {
+        const char *end = data + len;
+        while (data < end) {
+            if (!pending()) {
+                size_t ascii = asciiPrefix(data, size_t(end - data));
+                for (size_t i = 0; i < ascii; ++i) {
+                    output(uint32_t(static_cast<unsigned char>(data[i])));
+                }
+                data += ascii;
+            }
+            data = decode(data, end, output);
+        }
+    }
+
+    // Drops an unfinished sequence, e.g. when a control character interrupts it;
+    // returns true if there was one, which then stands for one U+FFFD
+    bool abandon() {
+        bool had = needed != 0;
+        needed = 0;
+        return had;
+    }
+
+private:
+    uint32_t codepoint = 0;
+    int needed = 0; // Continuation bytes still expected
+    unsigned char lower = 0x80, upper = 0xBF; // Range of the next continuation byte
+};
+
+#endif // UTF8DECODER_H
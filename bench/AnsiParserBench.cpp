@@ -0,0 +1,79 @@
+// AnsiParserBench.cpp
+//
+// Microbenchmark for AnsiParser. Feeds recorded shell output (or a synthetic mix of
+// plain text, SGR colours, OSC titles and cursor motion) through the parser in
+// PTY-sized chunks and reports the throughput.
+//
+// Build: g++ -std=c++17 -O2 -I.. AnsiParserBench.cpp ../AnsiParser.cpp -o AnsiParserBench
+// Usage: ./AnsiParserBench [recorded-output-file] [chunk-size]
+//        (record a workload with e.g. `script -q -c "ls --color -R /usr" out.log`)
+#include "AnsiParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// Counts what the parser reports so the work cannot be optimised away
+class CountingHandler : public AnsiHandler {
+public:
+    size_t printed = 0, controls = 0, sequences = 0;
+
+    void print(const char *, size_t len) override { printed += len; }
+    void execute(unsigned char) override { ++controls; }
+    void csiDispatch(const int *, int, char, const char *, int, char) override { ++sequences; }
+    void escDispatch(const char *, int, char) override { ++sequences; }
+    void oscDispatch(const char *, size_t) override { ++sequences; }
+};
+
+static std::string syntheticWorkload() {
+    std::string out;
+    for (int i = 0; i < 20000; ++i) {
+        out += "\033]0;user@host: ~/src\007";
+        out += "\033[01;32muser@host\033[00m:\033[01;34m~/src\033[00m$ ls --color\r\n";
+        out += "\033[0m\033[01;34mbuild\033[0m  \033[01;32mconfigure\033[0m  README.md  main.cpp\r\n";
+        out += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor\r\n";
+        out += "\033[?2004h\033[H\033[2J\033[38;5;208mwarning:\033[39m unused variable\033(B\r\n";
+    }
+    return out;
+}
+
+int main(int argc, char *argv[]) {
+    std::string input;
+    if (argc > 1) {
+        std::ifstream file(argv[1], std::ios::binary);
+        if (!file) {
+            perror(argv[1]);
+            return 1;
+        }
+        input.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    } else {
+        input = syntheticWorkload();
+    }
+    size_t chunk = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4096;
+    if (chunk == 0 || input.empty()) {
+        fprintf(stderr, "nothing to parse\n");
+        return 1;
+    }
+
+    CountingHandler handler;
+    AnsiParser parser(&handler);
+    const int passes = 20;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (size_t offset = 0; offset < input.size(); offset += chunk) {
+            parser.feed(input.data() + offset, std::min(chunk, input.size() - offset));
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double megabytes = double(input.size()) * passes / (1024.0 * 1024.0);
+    printf("input: %zu bytes x %d passes, chunk %zu\n", input.size(), passes, chunk);
+    printf("printed %zu bytes, %zu controls, %zu sequences\n", handler.printed, handler.controls, handler.sequences);
+    printf("throughput: %.1f MB/s\n", megabytes / seconds);
+    return 0;
+}
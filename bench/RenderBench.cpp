@@ -0,0 +1,85 @@
+// RenderBench.cpp
+//
+// Render benchmark for TerminalView. Fills an 80x24 and a 300x100 screen with
+// mixed-colour text (SGR runs of varying length, bold and inverse cells, a few wide
+// characters) and times full-screen repaints into a QImage, i.e. on Qt's software
+// raster backend. The first repaint, which fills the glyph atlas, is reported apart.
+//
+// Build: qmake RenderBench.pro && make
+// Usage: ./RenderBench [repaints]
+#include "TerminalScreen.h"
+#include "TerminalView.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Text with a colour change every few words, as produced by ls --color or a compiler
+static std::string colourfulScreen(int columns, int rows) {
+    static const char *words[] = {"build", "main.cpp", "error:", "warning", "src/", "TerminalView", "0x7ffd", "ok", "终端", "|"};
+    std::string out;
+    int n = 0;
+    for (int row = 0; row < rows; ++row) {
+        int width = 0;
+        while (width < columns - 14) {
+            const char *word = words[n % 10];
+            out += "\033[" + std::to_string(n % 3 == 0 ? 1 : 0) + ";" + std::to_string(31 + n % 7) + "m";
+            if (n % 11 == 0) {
+                out += "\033[7m"; // Inverse
+            }
+            if (n % 13 == 0) {
+                out += "\033[38;5;" + std::to_string(n % 256) + "m";
+            }
+            out += word;
+            out += "\033[0m ";
+            width += int(std::string(word).size()) + 1;
+            ++n;
+        }
+        if (row + 1 < rows) {
+            out += "\r\n";
+        }
+    }
+    return out;
+}
+
+static void benchmark(int columns, int rows, int repaints) {
+    TerminalScreen screen(columns, rows);
+    AnsiParser parser(&screen);
+    std::string text = colourfulScreen(columns, rows);
+    parser.feed(text.data(), text.size());
+
+    TerminalView view(&screen);
+    QSize cell = view.sizeHint(); // 80x24 cells
+    QSize pixels(cell.width() * columns / 80, cell.height() * rows / 24);
+    view.resize(pixels);
+    screen.resize(columns, rows); // The resize above reports a grid size nobody listens to
+
+    QImage image(pixels, QImage::Format_ARGB32_Premultiplied);
+
+    QElapsedTimer timer;
+    timer.start();
+    view.render(&image); // Cold: rasterises every glyph into the atlas
+    qint64 coldNs = timer.nsecsElapsed();
+
+    timer.restart();
+    for (int i = 0; i < repaints; ++i) {
+        view.render(&image);
+    }
+    double frameMs = timer.nsecsElapsed() / 1e6 / repaints;
+
+    printf("%3dx%-3d (%4dx%-4d px): first frame %.2f ms, full repaint %.3f ms (%.0f fps)\n",
+           columns, rows, pixels.width(), pixels.height(), coldNs / 1e6, frameMs, 1000.0 / frameMs);
+}
+
+int main(int argc, char *argv[]) {
+    qputenv("QT_QPA_PLATFORM", "offscreen"); // No display needed
+    QApplication app(argc, argv);
+    int repaints = argc > 1 ? atoi(argv[1]) : 200;
+
+    benchmark(80, 24, repaints);
+    benchmark(300, 100, repaints / 4 > 0 ? repaints / 4 : 1);
+    return 0;
+}
@@ -0,0 +1,25 @@
+QT += core gui widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = RenderBench
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    RenderBench.cpp \
+    ../AnsiParser.cpp \
+    ../GlyphAtlas.cpp \
+    ../Instrumentation.cpp \
+    ../Scrollback.cpp \
+    ../ScrollbackPool.cpp \
+    ../TerminalScreen.cpp \
+    ../TerminalView.cpp
+
+HEADERS += \
+    ../GlyphAtlas.h \
+    ../TerminalView.h
+
+LIBS += -lz
@@ -0,0 +1,72 @@
+// ScrollbackBench.cpp
+//
+// Memory benchmark for Scrollback. Appends build-log-like lines to the history and
+// reports the resident set size, the bytes held by the pages and how many pages are
+// compressed, then times random access into the cold (compressed) part.
+//
+// Build: g++ -std=c++17 -O2 -I.. ScrollbackBench.cpp ../Scrollback.cpp ../ScrollbackPool.cpp -lz -o ScrollbackBench
+// Usage: ./ScrollbackBench [lines] [max-lines] [max-bytes]
+//        (the defaults append 10M lines with a 10M line / 1 GiB cap)
+#include "Scrollback.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// Resident set size of this process in KiB, from /proc
+static long residentKiB() {
+    FILE *status = fopen("/proc/self/status", "r");
+    if (!status) {
+        return -1;
+    }
+    char line[256];
+    long kib = -1;
+    while (fgets(line, sizeof(line), status)) {
+        if (strncmp(line, "VmRSS:", 6) == 0) {
+            kib = strtol(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    fclose(status);
+    return kib;
+}
+
+int main(int argc, char *argv[]) {
+    size_t lines = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    size_t maxLines = argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000;
+    size_t maxBytes = argc > 3 ? strtoull(argv[3], nullptr, 10) : size_t(1) << 30;
+
+    long baseline = residentKiB();
+    Scrollback history(maxLines, maxBytes);
+    size_t rawBytes = 0;
+    char line[160];
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lines; ++i) {
+        int len = snprintf(line, sizeof(line), "[%6zu/%zu] Building CXX object src/module%zu/CMakeFiles/target.dir/file%zu.cpp.o",
+                           i % 1000000, lines, i % 97, i % 1013);
+        history.appendLine(line, size_t(len));
+        rawBytes += size_t(len) + 1;
+    }
+    double appendSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long rss = residentKiB();
+    printf("appended %zu lines (%.1f MiB of text) in %.2f s\n", lines, rawBytes / 1048576.0, appendSeconds);
+    printf("retained %zu lines in %zu pages (%zu compressed)\n", history.lineCount(), history.pageCount(), history.compressedPages());
+    printf("page storage: %.1f MiB, RSS: %.1f MiB (%.1f MiB above baseline)\n",
+           history.memoryUsage() / 1048576.0, rss / 1024.0, (rss - baseline) / 1024.0);
+
+    // Scrolling back: random lines across the retained history, each possibly inflating a page
+    std::mt19937_64 random(42);
+    const int lookups = 10000;
+    size_t touched = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups && history.lineCount() > 0; ++i) {
+        touched += history.line(random() % history.lineCount()).size();
+    }
+    double lookupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("random line lookup: %.1f us (%zu bytes read)\n", lookupSeconds * 1e6 / lookups, touched);
+    return 0;
+}
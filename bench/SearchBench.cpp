@@ -0,0 +1,97 @@
+// SearchBench.cpp
+//
+// Throughput benchmark for scrollback search. Builds a build-log-like history of the
+// given size and reports the scan rate of TextSearch::find() with every instruction set
+// the CPU supports (and libc memmem() for reference) over the plain text, then of
+// complete ScrollbackSearch runs, literal and regex, over the same text stored in a
+// Scrollback, where most pages are compressed and have to be inflated on the way. The
+// second set is the end-to-end rate the search bar sees; the first is only its ceiling.
+//
+// Build: g++ -std=c++17 -O2 -I.. SearchBench.cpp ../TextSearch.cpp ../ScrollbackSearch.cpp ../Scrollback.cpp ../ScrollbackPool.cpp ../TerminalScreen.cpp -lz -o SearchBench
+// Usage: ./SearchBench [MiB]
+//        (the default is a 1 GiB history)
+#include "ScrollbackSearch.h"
+#include "TextSearch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Occurrences of needle in text, using the given finder
+template <typename Find>
+static size_t countAll(const std::string &text, const std::string &needle, Find find) {
+    size_t count = 0;
+    const char *p = text.data();
+    const char *end = text.data() + text.size();
+    while (const char *hit = find(p, size_t(end - p), needle.data(), needle.size())) {
+        ++count;
+        p = hit + needle.size();
+    }
+    return count;
+}
+
+// Runs a search over the whole history, the way the search bar does
+static void timeSearch(const Scrollback &history, const char *label, const std::string &pattern, bool regex) {
+    ScrollbackSearch search(&history);
+    auto start = std::chrono::steady_clock::now();
+    search.setPattern(pattern, regex);
+    while (!search.caughtUp()) {
+        search.step(4 * 1024 * 1024);
+    }
+    double seconds = secondsSince(start);
+    printf("%-30s %8.2f GB/s  %7zu matches  (%s)\n", label, search.bytesScanned() / seconds / 1e9, search.matches().size(), pattern.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    size_t mib = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1024;
+    const size_t target = mib * 1024 * 1024;
+
+    // One in 50000 lines is an error worth finding
+    std::string text;
+    text.reserve(target + 256);
+    Scrollback history(size_t(-1), size_t(-1));
+    char line[200];
+    for (size_t i = 0; text.size() < target; ++i) {
+        int len = i % 50000 == 49999
+                      ? snprintf(line, sizeof(line), "src/module%zu/file%zu.cpp:%zu:13: error: use of undeclared identifier 'value%zu'", i % 97, i % 1013, i % 400, i)
+                      : snprintf(line, sizeof(line), "[%6zu] Building CXX object src/module%zu/CMakeFiles/target.dir/file%zu.cpp.o", i % 1000000, i % 97, i % 1013);
+        text.append(line, size_t(len));
+        text.push_back('\n');
+        history.appendLine(line, size_t(len));
+    }
+    printf("history: %.1f MiB of text, %zu lines, %zu pages (%zu compressed, %.1f MiB stored)\n\n",
+           text.size() / 1048576.0, history.lineCount(), history.pageCount(), history.compressedPages(), history.memoryUsage() / 1048576.0);
+
+    // Raw substring scan over contiguous memory
+    printf("raw find over plain text in memory (upper bound, not what a search costs):\n");
+    const std::string needle = "undeclared identifier";
+    for (int isa = TextSearch::Scalar; isa <= TextSearch::Avx2; ++isa) {
+        if (!TextSearch::supported(TextSearch::Isa(isa))) {
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        size_t count = countAll(text, needle, [isa](const char *t, size_t size, const char *n, size_t length) {
+            return TextSearch::find(TextSearch::Isa(isa), t, size, n, length);
+        });
+        double seconds = secondsSince(start);
+        printf("TextSearch::find %-13s %8.2f GB/s  %7zu matches\n", TextSearch::isaName(TextSearch::Isa(isa)), text.size() / seconds / 1e9, count);
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t count = countAll(text, needle, [](const char *t, size_t size, const char *n, size_t length) {
+        return static_cast<const char *>(memmem(t, size, n, length));
+    });
+    printf("memmem (libc)                  %8.2f GB/s  %7zu matches\n\n", text.size() / secondsSince(start) / 1e9, count);
+
+    // Whole searches over the paged, mostly compressed history
+    printf("end to end over the scrollback (inflate + find + line lookup), per byte of history text:\n");
+    timeSearch(history, "ScrollbackSearch literal", needle, false);
+    timeSearch(history, "ScrollbackSearch regex", "error: .* 'value[0-9]+'", true);
+    timeSearch(history, "ScrollbackSearch regex, no lit", "(error|warning): use", true); // Every line goes to std::regex
+    return 0;
+}
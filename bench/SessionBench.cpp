@@ -0,0 +1,100 @@
+// SessionBench.cpp
+//
+// Per-session overhead of SessionManager. Opens a window, then a number of shell
+// sessions (100 by default) as tabs, lets the shells start up and reports what each
+// extra session costs the emulator process: resident memory, file descriptors and
+// threads, plus the CPU the whole process burns while every shell sits idle at its
+// prompt. The shells' own memory is not included.
+//
+// Build: qmake SessionBench.pro && make
+// Usage: ./SessionBench [sessions]
+#include "SessionManager.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct ProcessUsage {
+    long rssKiB = 0;
+    int threads = 0;
+    int fds = 0;
+};
+
+static ProcessUsage processUsage() {
+    ProcessUsage usage;
+    if (FILE *status = fopen("/proc/self/status", "r")) {
+        char line[256];
+        while (fgets(line, sizeof(line), status)) {
+            if (strncmp(line, "VmRSS:", 6) == 0) {
+                usage.rssKiB = atol(line + 6);
+            } else if (strncmp(line, "Threads:", 8) == 0) {
+                usage.threads = atoi(line + 8);
+            }
+        }
+        fclose(status);
+    }
+    if (DIR *dir = opendir("/proc/self/fd")) {
+        while (struct dirent *entry = readdir(dir)) {
+            usage.fds += entry->d_name[0] != '.' ? 1 : 0;
+        }
+        closedir(dir);
+        --usage.fds; // The directory stream itself
+    }
+    return usage;
+}
+
+static double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void runEventLoop(int msec) {
+    QEventLoop loop;
+    QTimer::singleShot(msec, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+int main(int argc, char *argv[]) {
+    qputenv("QT_QPA_PLATFORM", "offscreen"); // No display needed
+    if (!qEnvironmentVariableIsSet("SHELL")) {
+        qputenv("SHELL", "/bin/sh");
+    }
+    QApplication app(argc, argv);
+    int sessions = argc > 1 ? atoi(argv[1]) : 100;
+
+    SessionManager manager;
+    manager.resize(800, 600);
+    manager.show();
+    runEventLoop(200);
+    ProcessUsage before = processUsage();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < sessions; ++i) {
+        manager.openSession();
+    }
+    double openMs = timer.nsecsElapsed() / 1e6;
+
+    runEventLoop(2000); // Shells start and print their prompts
+    ProcessUsage after = processUsage();
+
+    double cpuBefore = cpuSeconds();
+    runEventLoop(2000);
+    double idleCpu = (cpuSeconds() - cpuBefore) / 2.0 * 100.0;
+
+    int n = sessions > 0 ? sessions : 1;
+    printf("%d sessions opened in %.1f ms (%.2f ms each)\n", sessions, openMs, openMs / n);
+    printf("resident memory: %ld KiB -> %ld KiB, %.1f KiB per session\n", before.rssKiB, after.rssKiB, double(after.rssKiB - before.rssKiB) / n);
+    printf("file descriptors: %d -> %d, %.2f per session\n", before.fds, after.fds, double(after.fds - before.fds) / n);
+    printf("threads: %d -> %d\n", before.threads, after.threads);
+    printf("idle CPU with all shells at their prompt: %.2f%%\n", idleCpu);
+    printf("scrollback pool: %zu KiB in use, %zu spare pages\n", manager.scrollbackPool().memoryUsage() / 1024, manager.scrollbackPool().spareBuffers());
+    return 0;
+}
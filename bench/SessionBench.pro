@@ -0,0 +1,46 @@
+QT += core gui widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = SessionBench
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    SessionBench.cpp \
+    ../AnsiParser.cpp \
+    ../ByteRing.cpp \
+    ../GlyphAtlas.cpp \
+    ../InputWriter.cpp \
+    ../Instrumentation.cpp \
+    ../PtyChannel.cpp \
+    ../PtyReactor.cpp \
+    ../RenderScheduler.cpp \
+    ../Scrollback.cpp \
+    ../ScrollbackPool.cpp \
+    ../ScrollbackSearch.cpp \
+    ../SearchBar.cpp \
+    ../SessionManager.cpp \
+    ../ShellLauncher.cpp \
+    ../StatsOverlay.cpp \
+    ../TerminalEmulator.cpp \
+    ../TerminalScreen.cpp \
+    ../TerminalView.cpp \
+    ../TextSearch.cpp
+
+HEADERS += \
+    ../GlyphAtlas.h \
+    ../InputWriter.h \
+    ../PtyChannel.h \
+    ../PtyReactor.h \
+    ../RenderScheduler.h \
+    ../SearchBar.h \
+    ../SessionManager.h \
+    ../ShellLauncher.h \
+    ../StatsOverlay.h \
+    ../TerminalEmulator.h \
+    ../TerminalView.h
+
+LIBS += -lz
@@ -1,14 +1,34 @@
 // main.cpp
 #include <QApplication>
-#include "TerminalEmulator.h"
+#include "SessionManager.h"
+#include "StartupTrace.h"
+#include "Instrumentation.h"
+#include <cstdio> // perror
 
 int main(int argc, char *argv[]) {
+    StartupTrace::processStarted(); // TERME_STARTUP_TIMING=1 reports time to first prompt
     QApplication app(argc, argv);
+    TERME_THREAD_NAME("gui");
 
-    TerminalEmulator terminal;
-    terminal.setWindowTitle("Qt Terminal Emulator");
-    terminal.resize(800, 600);
-    terminal.show();
+    // TERME_TRACE=<file> records a Chrome trace of the timed phases (instrumented builds)
+    QByteArray tracePath = qgetenv("TERME_TRACE");
+    if (Instrumentation::compiledIn && !tracePath.isEmpty()) {
+        Instrumentation::startTrace();
+    }
 
-    return app.exec();
+    int status;
+    {
+        SessionManager sessions;
+        sessions.setWindowTitle("Qt Terminal Emulator");
+        sessions.resize(800, 600);
+        sessions.openSession();
+        sessions.show();
+
+        status = app.exec();
+    } // The sessions and the reactor thread are gone before the trace is written
+
+    if (Instrumentation::tracing() && !Instrumentation::writeTrace(tracePath.constData())) {
+        perror("writing trace failed");
+    }
+    return status;
 }
@@ -1,70 +1,700 @@
-#include <iostream>
-#include <unistd.h>
+// termE.cpp
+//
+// Headless throughput and latency benchmark for the PTY read path. Each workload is
+// written by a child process into the slave side of a raw-mode PTY while this process
+// drains the master the way the GUI's reactor does (ByteRing::fillFrom() after poll(),
+// then AnsiParser into a TerminalScreen whose scrolled-out lines go to a Scrollback), so
+// a regression anywhere on that path shows up as a lower MB/s or more allocations.
+//
+// Reported per workload:
+//   pty MB/s     bytes through the PTY and the parser per second of wall time
+//   parse MB/s   the same bytes parsed from memory, i.e. without the kernel
+//   allocs/MB    heap allocations made while draining and parsing one MiB through the PTY
+//   allocs/read  the same per read() of the master; history pages kept are the only
+//                steady-state allocations left, one per 64 KiB scrolled out
+// and, over a PTY with echo on, the p50/p99 time from writing a key to the master until
+// its echo has been read and applied to the screen.
+//
+// These columns measure this file's single threaded copy of the read path. --alloc-check
+// runs the workloads through the GUI's own PtyReactor and PtyChannel instead, taking and
+// returning updates the way TerminalEmulator does, and fails unless the reactor thread
+// makes no allocations at all once the first half of each workload has warmed it up.
+//
+// Workloads: a plain text flood (logs), ls --color style SGR-heavy listings, vim style
+// full-screen redraws with cursor addressing and scroll regions, and UTF-8 CJK text with
+// wide characters, plus the text flood again on a 300x100 grid, where scrolling has to
+// stay cheap however many cells the screen holds. Recordings (e.g. from script(1)) can
+// be replayed with --replay.
+// Each workload is also parsed in odd-sized pieces that split escape sequences and
+// UTF-8 characters; a warning is printed if that gives a different screen or history.
+//
+// --paste-check covers the input direction instead: it pastes 10 MiB through the GUI's
+// own InputWriter, PtyReactor and PtyChannel into a raw PTY whose reader checksums what
+// arrives, and exits non-zero if a byte was lost, reordered or altered on the way.
+//
+// Build: make termE (an extra target of CppTdoc.pro, which adds Qt Core and the moc
+//        output of the reactor classes)
+// Usage: ./termE [--size MiB] [--keys N] [--replay FILE]...
+//        ./termE [--size MiB] --alloc-check
+//        ./termE --paste-check
+//        ./termE --relay     (the original interactive relay to /bin/bash)
+#include "AnsiParser.h"
+#include "ByteRing.h"
+#include "InputWriter.h"
+#include "PtyReactor.h"
+#include "Scrollback.h"
+#include "ScrollbackPool.h"
+#include "TerminalScreen.h"
+
+#include <QCoreApplication>
+#include <QString>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
 #include <pty.h>
-#include <termios.h>
-#include <sys/ioctl.h>
 #include <signal.h>
-#include <poll.h>
-using namespace std;
-int main() {
-    int master_fd, slave_fd;
-    char slave_name[256];
-    if (openpty(&master_fd, &slave_fd, slave_name, NULL, NULL) == -1) {
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Every heap allocation in the process is counted; the benchmark only reads deltas.
+// Those made by other threads than main(), i.e. by the reactor, are also counted apart
+static std::atomic<size_t> allocations(0);
+static std::atomic<size_t> reactorAllocations(0);
+static std::thread::id mainThread;
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (std::this_thread::get_id() != mainThread) {
+        reactorAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void *p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+void operator delete(void *p) noexcept {
+    free(p);
+}
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// The GUI's read path minus the threads: ring buffer, parser, screen and history
+struct Session {
+    TerminalScreen screen;
+    AnsiParser parser;
+    ScrollbackPool pool; // Recycles page buffers, as in the GUI
+    Scrollback scrollback;
+    ByteRing readBuffer;
+    size_t reads = 0;
+
+    Session(int columns = 80, int rows = 24) : screen(columns, rows), parser(&screen), scrollback(Scrollback::DefaultMaxLines, Scrollback::DefaultMaxBytes, &pool) {
+        screen.onLineScrolledOut = [this](const Cell *cells, int count) { scrollback.appendCells(cells, count); };
+    }
+
+    // Drains and parses whatever the master has; false once the other side is gone
+    bool drain(int fd, size_t &bytes) {
+        ByteRing::FillResult result = readBuffer.fillFrom(fd, reads, bytes);
+        while (!readBuffer.isEmpty()) {
+            ByteRing::Span span = readBuffer.readSpan();
+            parser.feed(span.data, span.size);
+            readBuffer.consume(span.size);
+        }
+        screen.takeResponses();
+        screen.clearDamage();
+        return result != ByteRing::EndOfFile;
+    }
+};
+
+// --- Workloads -----------------------------------------------------------------------
+
+static std::string textFlood(size_t size) {
+    static const char *levels[] = {"INFO", "DEBUG", "WARN", "INFO", "TRACE"};
+    std::string out;
+    char line[160];
+    for (unsigned n = 0; out.size() < size; ++n) {
+        int len = snprintf(line, sizeof(line), "2024-05-01 12:%02u:%02u.%03u %-5s worker-%02u processed request %u in %u ms\r\n",
+                           n / 60000 % 60, n / 1000 % 60, n % 1000, levels[n % 5], n % 16, 100000 + n * 7, n % 97);
+        out.append(line, size_t(len));
+    }
+    return out;
+}
+
+static std::string lsColor(size_t size) {
+    static const char *kinds[] = {"\033[01;34m", "\033[01;32m", "", "\033[01;36m", "\033[00m", "\033[01;31m"};
+    static const char *suffixes[] = {"", ".sh", ".txt", "", ".cpp", ".tar.gz"};
+    std::string out;
+    char name[64];
+    for (unsigned n = 0; out.size() < size; ++n) {
+        int kind = int(n % 6);
+        snprintf(name, sizeof(name), "entry_%05u%s", n, suffixes[kind]);
+        if (*kinds[kind]) {
+            out += kinds[kind];
+            out += name;
+            out += "\033[0m";
+        } else {
+            out += name;
+        }
+        size_t pad = 20 - std::min<size_t>(strlen(name), 19);
+        out += n % 4 == 3 ? std::string("\r\n") : std::string(pad, ' ');
+    }
+    return out;
+}
+
+static std::string vimRedraws(size_t size) {
+    static const char *code[] = {"    for (int i = 0; i < count; ++i) {", "        total += values[i];", "    }", "    return total;",
+                                 "int sum(const int *values, int count) {", "    int total = 0;", "}", "// Accumulates the values"};
+    std::string out;
+    char buf[64];
+    for (unsigned frame = 0; out.size() < size; ++frame) {
+        if (frame % 4 == 3) {
+            // Ctrl-E style scroll: one new line at the bottom of a scroll region
+            out += "\033[1;23r\033[23;1H\n\033[38;5;244m";
+            snprintf(buf, sizeof(buf), "%4u ", frame);
+            out += buf;
+            out += "\033[0m";
+            out += code[frame % 8];
+            out += "\033[K\033[r";
+        } else {
+            // Full redraw: every text row addressed, highlighted and cleared to the end
+            out += "\033[?25l\033[H";
+            for (int row = 1; row <= 23; ++row) {
+                snprintf(buf, sizeof(buf), "\033[%d;1H\033[38;5;244m%4u \033[0m", row, frame + unsigned(row));
+                out += buf;
+                const char *text = code[(frame + unsigned(row)) % 8];
+                if (strncmp(text, "    ", 4) == 0 && text[4] != ' ') {
+                    out += "    \033[1;38;5;208m";
+                    out.append(text + 4, 3);
+                    out += "\033[0m";
+                    out += text + 7;
+                } else {
+                    out += "\033[38;5;71m";
+                    out += text;
+                    out += "\033[0m";
+                }
+                out += "\033[K";
+            }
+        }
+        snprintf(buf, sizeof(buf), "\033[24;1H\033[7m sum.cpp [+]   %u,5   All \033[0m\033[K", frame % 23 + 1);
+        out += buf;
+        snprintf(buf, sizeof(buf), "\033[%u;9H\033[?25h", frame % 23 + 1);
+        out += buf;
+    }
+    return out;
+}
+
+static std::string utf8Cjk(size_t size) {
+    static const char *phrases[] = {"终端模拟器", "性能测试", "日本語のテキスト", "한국어 문장", "漢字とかな", "🚀 emoji ✅", "混合 mixed 文本"};
+    std::string out;
+    for (unsigned n = 0; out.size() < size; ++n) {
+        for (int i = 0; i < 5; ++i) {
+            out += phrases[(n + unsigned(i)) % 7];
+            out += ' ';
+        }
+        out += "\r\n";
+    }
+    return out;
+}
+
+static bool readFile(const char *path, std::string &data) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    char chunk[65536];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.append(chunk, count);
+    }
+    fclose(file);
+    return true;
+}
+
+// --- Measurements --------------------------------------------------------------------
+
+// Pushes data through a raw-mode PTY into a Session; returns the seconds taken
+static double pipeThroughPty(const std::string &data, int columns, int rows, size_t &allocs, size_t &reads) {
+    int masterFd, slaveFd;
+    struct winsize size = {};
+    size.ws_col = static_cast<unsigned short>(columns);
+    size.ws_row = static_cast<unsigned short>(rows);
+    if (openpty(&masterFd, &slaveFd, nullptr, nullptr, &size) == -1) {
+        perror("openpty");
+        exit(1);
+    }
+    struct termios raw;
+    tcgetattr(slaveFd, &raw);
+    cfmakeraw(&raw); // Bytes arrive exactly as written, without \n -> \r\n or echo
+    tcsetattr(slaveFd, TCSANOW, &raw);
+
+    Session session(columns, rows);
+    Clock::time_point start = Clock::now();
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        ::close(masterFd);
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t count = write(slaveFd, data.data() + written, data.size() - written);
+            if (count <= 0) {
+                _exit(1);
+            }
+            written += size_t(count);
+        }
+        _exit(0);
+    }
+    ::close(slaveFd);
+    fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+
+    size_t before = allocations;
+    size_t bytes = 0;
+    for (;;) {
+        struct pollfd fd = {masterFd, POLLIN, 0};
+        if (poll(&fd, 1, -1) == -1) {
+            perror("poll");
+            break;
+        }
+        if (!session.drain(masterFd, bytes)) {
+            break;
+        }
+    }
+    double seconds = secondsSince(start);
+    allocs = allocations - before;
+    reads = session.reads;
+
+    ::close(masterFd);
+    waitpid(pid, nullptr, 0);
+    if (bytes != data.size()) {
+        fprintf(stderr, "warning: %zu of %zu bytes arrived\n", bytes, data.size());
+    }
+    return seconds;
+}
+
+static double parseFromMemory(const std::string &data, size_t chunk, Session &session) {
+    Clock::time_point start = Clock::now();
+    for (size_t offset = 0; offset < data.size(); offset += chunk) {
+        session.parser.feed(data.data() + offset, std::min(chunk, data.size() - offset));
+        session.screen.clearDamage();
+    }
+    return secondsSince(start);
+}
+
+// Same screen contents and history, cell by cell
+static bool sameContents(const Session &a, const Session &b) {
+    for (int row = 0; row < a.screen.rows(); ++row) {
+        for (int col = 0; col < a.screen.columns(); ++col) {
+            const Cell &x = a.screen.row(row)[col];
+            const Cell &y = b.screen.row(row)[col];
+            if (x.codepoint != y.codepoint || !x.sameStyle(y)) {
+                return false;
+            }
+        }
+    }
+    size_t lines = a.scrollback.lineCount();
+    return lines == b.scrollback.lineCount() && (lines == 0 || a.scrollback.line(lines - 1) == b.scrollback.line(lines - 1));
+}
+
+static void runWorkload(const char *name, const std::string &data, int columns = 80, int rows = 24) {
+    double mib = double(data.size()) / (1024 * 1024);
+    size_t allocs = 0, reads = 0;
+    double pty = pipeThroughPty(data, columns, rows, allocs, reads);
+    Session whole(columns, rows), split(columns, rows);
+    double parse = parseFromMemory(data, 65536, whole);
+    parseFromMemory(data, 4093, split); // Odd-sized, so pieces end inside sequences and characters
+    printf("%-14s %8.1f MiB %10.1f %11.1f %11.1f %11.3f\n", name, mib, mib / pty, mib / parse, double(allocs) / mib, double(allocs) / double(std::max<size_t>(reads, 1)));
+    if (!sameContents(whole, split)) {
+        printf("warning: %s parses differently when split into 4093 byte pieces\n", name);
+    }
+    fflush(stdout);
+}
+
+// Writes single keys to a cooked PTY and times each echo through the read path
+static void echoLatency(int keys) {
+    int masterFd, slaveFd;
+    if (openpty(&masterFd, &slaveFd, nullptr, nullptr, nullptr) == -1) {
+        perror("openpty");
+        exit(1);
+    }
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        // Stands in for a shell waiting at its prompt: consumes the lines, the line
+        // discipline does the echo
+        ::close(masterFd);
+        char buffer[4096];
+        while (read(slaveFd, buffer, sizeof(buffer)) > 0) {
+        }
+        _exit(0);
+    }
+    ::close(slaveFd);
+    fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+
+    Session session;
+    std::vector<double> samples;
+    samples.reserve(size_t(keys));
+    size_t bytes = 0;
+    for (int i = 0; i < keys; ++i) {
+        if (i % 64 == 63) {
+            // End the line so the canonical buffer never fills; not timed
+            write(masterFd, "\r", 1);
+            size_t target = bytes + 2;
+            while (bytes < target) {
+                struct pollfd fd = {masterFd, POLLIN, 0};
+                poll(&fd, 1, 1000);
+                session.drain(masterFd, bytes);
+            }
+        }
+        char key = char('a' + i % 26);
+        Clock::time_point start = Clock::now();
+        write(masterFd, &key, 1);
+        size_t target = bytes + 1;
+        while (bytes < target) {
+            struct pollfd fd = {masterFd, POLLIN, 0};
+            if (poll(&fd, 1, 1000) <= 0) {
+                fprintf(stderr, "echo timed out\n");
+                break;
+            }
+            session.drain(masterFd, bytes);
+        }
+        samples.push_back(secondsSince(start) * 1e6);
+    }
+
+    kill(pid, SIGKILL);
+    ::close(masterFd);
+    waitpid(pid, nullptr, 0);
+
+    std::sort(samples.begin(), samples.end());
+    if (!samples.empty()) {
+        printf("input-to-echo latency over %d keys: p50 %.1f us, p99 %.1f us, max %.1f us\n", keys,
+               samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.back());
+    }
+}
+
+// Streams data through the reactor into a channel while this thread takes each update
+// and hands it back, as TerminalEmulator does; returns the allocations the reactor
+// thread made once the buffers passed around had grown to the workload's needs, i.e.
+// after half of the data and at least WarmUpUpdates updates have been published
+static size_t reactorSteadyAllocations(const std::string &data, size_t &updatesTaken, size_t &steadyUpdates) {
+    static constexpr size_t WarmUpUpdates = 8;
+    int masterFd, slaveFd;
+    if (openpty(&masterFd, &slaveFd, nullptr, nullptr, nullptr) == -1) {
+        perror("openpty");
+        exit(1);
+    }
+    struct termios raw;
+    tcgetattr(slaveFd, &raw);
+    cfmakeraw(&raw);
+    tcsetattr(slaveFd, TCSANOW, &raw);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        ::close(masterFd);
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t count = write(slaveFd, data.data() + written, data.size() - written);
+            if (count <= 0) {
+                _exit(1);
+            }
+            written += size_t(count);
+        }
+        _exit(0);
+    }
+    ::close(slaveFd);
+    fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+
+    PtyReactor reactor;
+    reactor.start();
+    PtyChannel *channel = reactor.open(masterFd, 80, 24);
+    ScreenUpdate update;
+    size_t bytes = 0, before = 0;
+    bool warm = false, eof = false;
+    while (!eof) {
+        channel->acknowledgeUpdates();
+        while (channel->takeUpdate(update)) {
+            bytes += update.bytes;
+            eof = eof || update.eof;
+            ++updatesTaken;
+        }
+        if (!warm && bytes >= data.size() / 2 && updatesTaken >= WarmUpUpdates) {
+            warm = true;
+            before = reactorAllocations.load();
+            steadyUpdates = updatesTaken;
+        }
+        usleep(1000); // Roughly the pace of a GUI that is busy painting
+    }
+    size_t allocs = reactorAllocations.load() - before; // Closing the channel allocates, so count first
+    steadyUpdates = warm ? updatesTaken - steadyUpdates : 0;
+
+    reactor.close(channel);
+    reactor.stop();
+    waitpid(pid, nullptr, 0);
+    return allocs;
+}
+
+static bool allocCheck(size_t size) {
+    struct Workload {
+        const char *name;
+        std::string (*generate)(size_t);
+    } workloads[] = {{"text-flood", textFlood}, {"ls-color", lsColor}, {"vim-redraw", vimRedraws}, {"utf8-cjk", utf8Cjk}};
+    bool ok = true;
+    for (const Workload &workload : workloads) {
+        size_t updates = 0, steadyUpdates = 0;
+        size_t allocs = reactorSteadyAllocations(workload.generate(size), updates, steadyUpdates);
+        printf("alloc-check %-14s %zu reactor allocations over the last %zu of %zu updates\n", workload.name, allocs, steadyUpdates, updates);
+        if (steadyUpdates == 0) {
+            printf("alloc-check %-14s too few updates to warm up; try a larger --size\n", workload.name);
+        }
+        ok = ok && allocs == 0 && steadyUpdates > 0;
+    }
+    printf("alloc-check: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// FNV-1a over a byte stream, for comparing what was pasted with what arrived
+static uint64_t checksum(uint64_t hash, const char *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Text to paste and the bytes the shell should receive for it: line breaks become CR
+// and the whole is wrapped in bracketed paste markers. The text starts with an end
+// marker hidden inside another, which must not survive into the paste
+static void pasteText(size_t size, std::string &text, std::string &expected) {
+    static const char *lines[] = {"for f in *.log; do gzip -9 \"$f\"; done", "    echo 'déjà vu — 終端 ✅'", "git commit -m \"Fix the build\"", ""};
+    text = "\033[20\033[201~1~";
+    expected = "\033[200~";
+    for (unsigned n = 0; text.size() < size; ++n) {
+        const char *line = lines[n % 4];
+        text += line;
+        text += '\n';
+        expected += line;
+        expected += '\r';
+    }
+    expected += "\033[201~";
+}
+
+// Pastes through InputWriter and the reactor into a raw PTY; true if every byte arrived
+static bool pasteCheck(size_t size) {
+    std::string text, expected;
+    pasteText(size, text, expected);
+    const uint64_t sent = checksum(0xcbf29ce484222325ull, expected.data(), expected.size());
+
+    int masterFd, slaveFd, results[2];
+    if (openpty(&masterFd, &slaveFd, nullptr, nullptr, nullptr) == -1 || pipe(results) == -1) {
+        perror("openpty");
+        exit(1);
+    }
+    struct termios raw;
+    tcgetattr(slaveFd, &raw);
+    cfmakeraw(&raw); // No echo, no CR -> NL: the reader sees exactly what was written
+    tcsetattr(slaveFd, TCSANOW, &raw);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        // Stands in for a shell reading the paste; reports the byte count and checksum
+        ::close(masterFd);
+        ::close(results[0]);
+        uint64_t received[2] = {0, 0xcbf29ce484222325ull};
+        char buffer[65536];
+        while (received[0] < expected.size()) {
+            ssize_t count = read(slaveFd, buffer, sizeof(buffer));
+            if (count <= 0) {
+                break;
+            }
+            received[0] += uint64_t(count);
+            received[1] = checksum(received[1], buffer, size_t(count));
+        }
+        write(results[1], received, sizeof(received));
+        _exit(0);
+    }
+    ::close(slaveFd);
+    ::close(results[1]);
+    fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+
+    PtyReactor reactor;
+    reactor.start();
+    PtyChannel *channel = reactor.open(masterFd, 80, 24);
+    InputWriter writer(channel);
+    Clock::time_point start = Clock::now();
+    writer.paste(QString::fromUtf8(text.data(), qsizetype(text.size())), true);
+
+    uint64_t received[2] = {0, 0};
+    ScreenUpdate update;
+    for (;;) {
+        // The writer refills the channel from inputSpace(), a queued signal
+        QCoreApplication::processEvents();
+        channel->acknowledgeUpdates();
+        while (channel->takeUpdate(update)) {
+        }
+        struct pollfd fd = {results[0], POLLIN, 0};
+        if (poll(&fd, 1, 1) > 0) {
+            if (read(results[0], received, sizeof(received)) != ssize_t(sizeof(received))) {
+                fprintf(stderr, "paste reader failed\n");
+            }
+            break;
+        }
+        if (secondsSince(start) > 60) {
+            fprintf(stderr, "paste timed out with %lld bytes still queued\n", static_cast<long long>(writer.pendingBytes()));
+            kill(pid, SIGKILL);
+            break;
+        }
+    }
+    double seconds = secondsSince(start);
+
+    reactor.close(channel);
+    reactor.stop();
+    ::close(results[0]);
+    waitpid(pid, nullptr, 0);
+
+    bool ok = received[0] == expected.size() && received[1] == sent;
+    printf("paste-check: %.1f MiB in %.2f s (%.1f MB/s), %llu of %zu bytes arrived, checksum %s\n", expected.size() / 1048576.0, seconds,
+           expected.size() / 1048576.0 / seconds, static_cast<unsigned long long>(received[0]), expected.size(), ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+// The original termE: an interactive relay between this terminal and a bash on a PTY
+static int relay() {
+    int masterFd, slaveFd;
+    if (openpty(&masterFd, &slaveFd, nullptr, nullptr, nullptr) == -1) {
         perror("openpty");
         return 1;
     }
-    cout << "Slave terminal name: " << slave_name << endl;
     pid_t pid = fork();
     if (pid == -1) {
         perror("fork");
         return 1;
     }
-    if (pid == 0) { 
-        close(master_fd);
-        setsid(); 
-        if (ioctl(slave_fd, TIOCSCTTY, 0) == -1) {
+    if (pid == 0) {
+        ::close(masterFd);
+        setsid();
+        if (ioctl(slaveFd, TIOCSCTTY, 0) == -1) {
             perror("ioctl");
             return 1;
         }
-        dup2(slave_fd, STDIN_FILENO);
-        dup2(slave_fd, STDOUT_FILENO);
-        dup2(slave_fd, STDERR_FILENO);
-        close(slave_fd);
+        dup2(slaveFd, STDIN_FILENO);
+        dup2(slaveFd, STDOUT_FILENO);
+        dup2(slaveFd, STDERR_FILENO);
+        ::close(slaveFd);
         execlp("/bin/bash", "bash", nullptr);
         perror("execlp");
         return 1;
-    } else { 
-        close(slave_fd);
-
-        struct pollfd fds[2];
-        fds[0].fd = master_fd;      
-        fds[0].events = POLLIN;
-        fds[1].fd = STDIN_FILENO;    
-        fds[1].events = POLLIN;
-        char buffer[256];
-        while (true) {
-            int ret = poll(fds, 2, -1); 
-            if (ret == -1) {
-                perror("poll");
-                break;
-            }
-            if (fds[0].revents & POLLIN) { 
-                ssize_t count = read(master_fd, buffer, sizeof(buffer) - 1);
-                if (count > 0) {
-                    buffer[count] = '\0';
-                   cout << buffer; 
-                }
+    }
+    ::close(slaveFd);
+
+    struct pollfd fds[2];
+    fds[0].fd = masterFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = STDIN_FILENO;
+    fds[1].events = POLLIN;
+    char buffer[4096];
+    for (;;) {
+        if (poll(fds, 2, -1) == -1) {
+            perror("poll");
+            break;
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP)) {
+            ssize_t count = read(masterFd, buffer, sizeof(buffer));
+            if (count <= 0) {
+                break; // The shell exited
             }
-            if (fds[1].revents & POLLIN) { 
-                ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer) - 1);
-                if (count > 0) {
-                    buffer[count] = '\0';
-                    write(master_fd, buffer, count);
-                }
+            write(STDOUT_FILENO, buffer, size_t(count));
+        }
+        if (fds[1].revents & POLLIN) {
+            ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (count <= 0) {
+                break;
             }
+            write(masterFd, buffer, size_t(count));
         }
     }
-
     return 0;
 }
 
+int main(int argc, char *argv[]) {
+    mainThread = std::this_thread::get_id();
+    size_t size = 16 * 1024 * 1024;
+    int keys = 5000;
+    bool checkAllocations = false;
+    std::vector<const char *> replays;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--relay") == 0) {
+            return relay();
+        } else if (strcmp(argv[i], "--paste-check") == 0) {
+            QCoreApplication app(argc, argv); // Delivers the channel's queued signals
+            return pasteCheck(10 * 1024 * 1024) ? 0 : 1;
+        } else if (strcmp(argv[i], "--alloc-check") == 0) {
+            checkAllocations = true;
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = size_t(atof(argv[++i]) * 1024 * 1024);
+        } else if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            keys = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replays.push_back(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--size MiB] [--keys N] [--replay FILE]... | [--size MiB] --alloc-check | --paste-check | --relay\n", argv[0]);
+            return 2;
+        }
+    }
+    if (checkAllocations) {
+        return allocCheck(size) ? 0 : 1;
+    }
+
+    printf("%-14s %12s %10s %11s %11s %11s\n", "workload", "size", "pty MB/s", "parse MB/s", "allocs/MB", "allocs/read");
+    runWorkload("text-flood", textFlood(size));
+    runWorkload("ls-color", lsColor(size));
+    runWorkload("vim-redraw", vimRedraws(size));
+    runWorkload("utf8-cjk", utf8Cjk(size));
+    runWorkload("flood-300x100", textFlood(size), 300, 100); // Every line feed scrolls a large grid
+    for (const char *path : replays) {
+        std::string data;
+        if (readFile(path, data)) {
+            const char *slash = strrchr(path, '/');
+            runWorkload(slash ? slash + 1 : path, data);
+        }
+    }
+    echoLatency(keys);
+    return 0;
+}